@@ -0,0 +1,58 @@
+#include <catch2/catch.hpp>
+
+#include "moon/moon.h"
+
+static int Add(int a, int b) { return a + b; }
+
+TEST_CASE("call Lua functions from C++ benchmark", "[functions][benchmark]") {
+    Moon::Init();
+    CHECK(Moon::RunCode("function Add(a, b) return a + b end; function Echo(s) return s end"));
+    auto add = Moon::At("Add").Get<moon::Object>();
+    auto cached = Moon::MakeFunction<int(int, int)>("Add");
+    auto stl = Moon::Get<std::function<int(int, int)>>("Add");
+    auto callback = Moon::Get<moon::Callback<int(int, int)>>("Add");
+    auto trusted = callback;
+    trusted.SetMode(moon::CallbackMode::Unprotected);
+    CHECK(Moon::Call<int>("Add", 1, 2) == 3);
+    CHECK(add.Call<int>(1, 2) == 3);
+    CHECK(cached(1, 2) == 3);
+    CHECK(stl(1, 2) == 3);
+    CHECK(callback(1, 2) == 3);
+
+    BENCHMARK("Moon::Call") { return Moon::Call<int>("Add", 1, 2); };
+    BENCHMARK("Moon::Call string") { return Moon::Call<std::string>("Echo", "passed"); };
+    BENCHMARK("Object::Call") { return add.Call<int>(1, 2); };
+    BENCHMARK("Function::operator()") { return cached(1, 2); };
+    BENCHMARK("std::function") { return stl(1, 2); };
+    BENCHMARK("Callback::operator()") { return callback(1, 2); };
+    BENCHMARK("Callback::operator() unprotected") { return trusted(1, 2); };
+
+    Moon::CloseState();
+}
+
+TEST_CASE("call C++ functions from Lua benchmark", "[functions][benchmark]") {
+    Moon::Init();
+    Moon::RegisterFunction("Lambda", [](int a, int b) { return a + b; });
+    Moon::RegisterFunction("Pointer", Add);
+    Moon::RegisterFunction<Add>("Static");
+    Moon::RegisterFunction("Strings", [](const std::string& s) { return s; });
+    auto lambda = Moon::CompileCode("local r = 0 for i = 1, 1000 do r = Lambda(i, r) end return r");
+    auto pointer = Moon::CompileCode("local r = 0 for i = 1, 1000 do r = Pointer(i, r) end return r");
+    auto plain = Moon::CompileCode("local r = 0 for i = 1, 1000 do r = Static(i, r) end return r");
+    auto strings = Moon::CompileCode("local r for i = 1, 1000 do r = Strings('passed') end return r");
+
+    BENCHMARK("1000 lambda calls") {
+        lambda.Run(0);
+    };
+    BENCHMARK("1000 function pointer calls") {
+        pointer.Run(0);
+    };
+    BENCHMARK("1000 static function calls") {
+        plain.Run(0);
+    };
+    BENCHMARK("1000 string function calls") {
+        strings.Run(0);
+    };
+
+    Moon::CloseState();
+}
@@ -0,0 +1,70 @@
+#include <catch2/catch.hpp>
+
+#include "moon/moon.h"
+
+TEST_CASE("container marshalling benchmark", "[containers][benchmark]") {
+    Moon::Init();
+
+    for (size_t size : {10, 1000, 100000}) {
+        std::vector<double> vector(size, 1.5);
+        std::map<std::string, int> map;
+        for (size_t i = 0; i < size; ++i) {
+            map.emplace(std::to_string(i), (int)i);
+        }
+        Moon::Set("vector", vector, "map", map);
+        auto suffix = " " + std::to_string(size);
+
+        BENCHMARK("push vector" + suffix) {
+            Moon::Push(vector);
+            Moon::Pop();
+        };
+        BENCHMARK("get vector" + suffix) { return Moon::Get<std::vector<double>>("vector"); };
+        BENCHMARK("push array buffer" + suffix) {
+            moon::Stack::PushArray(Moon::GetState(), vector.data(), vector.size());
+            Moon::Pop();
+        };
+        BENCHMARK("push map" + suffix) {
+            Moon::Push(map);
+            Moon::Pop();
+        };
+        BENCHMARK("get map" + suffix) { return Moon::Get<std::map<std::string, int>>("map"); };
+    }
+
+    Moon::CloseState();
+}
+
+TEST_CASE("set and nested lookup benchmark", "[basic][benchmark]") {
+    Moon::Init();
+    CHECK(Moon::RunCode("a = {b = {c = {d = {e = {f = {g = {h = 1}}}}}}}"));
+
+    BENCHMARK("Set") { Moon::Set("value", 1); };
+    BENCHMARK("Set pairs") { Moon::Set("x", 1, "y", 2.0, "z", "string"); };
+    BENCHMARK("SetNested depth 3") { Moon::SetNested("n", "m", "o", 1); };
+
+    BENCHMARK("lookup depth 1") { return Moon::At("a").GetType(); };
+    BENCHMARK("lookup depth 2") { return Moon::At("a")["b"].GetType(); };
+    BENCHMARK("lookup depth 4") { return Moon::At("a")["b"]["c"]["d"].GetType(); };
+    BENCHMARK("lookup depth 8") { return Moon::At("a")["b"]["c"]["d"]["e"]["f"]["g"]["h"].Get<int>(); };
+
+    auto path = Moon::MakePath("a", "b", "c", "d", "e", "f", "g", "h");
+    auto cached = Moon::MakePath("a", "b", "c", "d", "e", "f", "g", "h");
+    cached.CacheParent();
+    CHECK(path.Get<int>() == 1);
+    CHECK(cached.Get<int>() == 1);
+    BENCHMARK("path depth 8") { return path.Get<int>(); };
+    BENCHMARK("cached path depth 8") { return cached.Get<int>(); };
+
+    {
+        Moon::Set("frame", 1);
+        auto frame = Moon::MakeKey("frame");
+        auto b = Moon::MakeKey("b");
+        CHECK(Moon::Get<int>(frame) == 1);
+        BENCHMARK("Get global") { return Moon::Get<int>("frame"); };
+        BENCHMARK("Get interned global") { return Moon::Get<int>(frame); };
+        BENCHMARK("Set interned global") { Moon::Set(frame, 1); };
+        BENCHMARK("GetType depth 2") { return Moon::GetType("a", "b"); };
+        BENCHMARK("GetType interned depth 2") { return Moon::GetType("a", b); };
+    }
+
+    Moon::CloseState();
+}
@@ -0,0 +1,40 @@
+#include <catch2/catch.hpp>
+
+#include "moon/moon.h"
+
+TEST_CASE("script compilation benchmark", "[scripting][benchmark]") {
+    Moon::Init();
+    const char* code = "local t = {} for i = 1, 10 do t[i] = i * 2 end return t[10]";
+    auto chunk = Moon::CompileCode(code);
+    CHECK(chunk.IsLoaded());
+
+    BENCHMARK("RunCode") { return Moon::RunCode(code); };
+    BENCHMARK("RunCachedCode") { return Moon::RunCachedCode(code); };
+    BENCHMARK("Chunk::Run") { return chunk.Run(0); };
+
+    Moon::CloseState();
+}
+
+TEST_CASE("object creation and garbage collection benchmark", "[gc][benchmark]") {
+    Moon::Init();
+    Moon::RegisterFunction("Add", [](int a, int b) { return a + b; });
+    auto tables = Moon::CompileCode("for i = 1, 1000 do local t = {i} end");
+
+    BENCHMARK("MakeObject and release") { return Moon::MakeObject(1).GetKey(); };
+    BENCHMARK("copy shared object") {
+        auto object = Moon::MakeObject(1);
+        object.Share();
+        auto copy = object;
+        return copy.GetKey();
+    };
+    BENCHMARK("1000 tables and full collection") {
+        tables.Run(0);
+        Moon::GC().Collect();
+    };
+    BENCHMARK("register function and full collection") {
+        Moon::RegisterFunction("Temporary", [](int a) { return a; });
+        Moon::GC().Collect();
+    };
+
+    Moon::CloseState();
+}
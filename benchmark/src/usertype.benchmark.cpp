@@ -0,0 +1,67 @@
+#include <catch2/catch.hpp>
+
+#include "moon/moon.h"
+
+class BenchmarkType {
+public:
+    explicit BenchmarkType(lua_State* L) : value(moon::Core::Get<int>(L, 1)), m_value(value) {}
+
+    MOON_DECLARE_CLASS(BenchmarkType)
+
+    MOON_PROPERTY(m_value)
+
+    MOON_METHOD(Legacy) {
+        moon::Core::Push(L, m_value + moon::Core::Get<int>(L, 1));
+        return 1;
+    }
+
+    [[nodiscard]] int Typed(int other) const { return m_value + other; }
+
+    int value{0};
+
+private:
+    int m_value{0};
+};
+
+MOON_DEFINE_BINDING(BenchmarkType)
+MOON_ADD_PROPERTY(m_value)
+MOON_ADD_MEMBER(value)
+MOON_ADD_METHOD(Legacy)
+MOON_ADD_METHOD(Typed);
+
+TEST_CASE("bound class methods and properties benchmark", "[binding][benchmark]") {
+    Moon::Init();
+    Moon::RegisterClass<BenchmarkType>();
+    CHECK(Moon::RunCode("object = BenchmarkType(1)"));
+    auto legacy = Moon::CompileCode("local r = 0 for i = 1, 1000 do r = object:Legacy(i) end return r");
+    auto typed = Moon::CompileCode("local r = 0 for i = 1, 1000 do r = object:Typed(i) end return r");
+    auto property = Moon::CompileCode("for i = 1, 1000 do object.m_value = object.m_value + 1 end");
+    auto member = Moon::CompileCode("for i = 1, 1000 do object.value = object.value + 1 end");
+    auto construct = Moon::CompileCode("for i = 1, 1000 do local o = BenchmarkType(i) end");
+
+    BENCHMARK("1000 legacy method calls") {
+        legacy.Run(0);
+    };
+    BENCHMARK("1000 typed method calls") {
+        typed.Run(0);
+    };
+    BENCHMARK("1000 property get and set") {
+        property.Run(0);
+    };
+    BENCHMARK("1000 member get and set") {
+        member.Run(0);
+    };
+    BENCHMARK("1000 object constructions") {
+        construct.Run(0);
+    };
+
+    auto* object = Moon::Get<BenchmarkType*>("object");
+    BENCHMARK("1000 borrowed pushes of same object") {
+        for (int i = 0; i < 1000; ++i) {
+            Moon::Push(moon::Borrow(object));
+            Moon::Pop();
+        }
+    };
+
+    Moon::CloseState();
+}
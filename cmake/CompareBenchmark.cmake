@@ -0,0 +1,97 @@
+cmake_minimum_required(VERSION 3.10)
+
+# Compares mean of each benchmark in Catch2 XML results against a baseline XML, failing if any exceeds the tolerance.
+# Expects RESULTS, BASELINE and TOLERANCE (percentage) to be defined.
+
+if (NOT EXISTS "${RESULTS}")
+    message(FATAL_ERROR "Benchmark results not found: ${RESULTS}")
+endif ()
+
+if (NOT EXISTS "${BASELINE}")
+    message(FATAL_ERROR "Benchmark baseline not found: ${BASELINE}. Run moon_benchmark_baseline first")
+endif ()
+
+if (NOT TOLERANCE)
+    set(TOLERANCE 10)
+endif ()
+
+# Reads XML file and sets <prefix>_NAMES with benchmark names and <prefix>_<index> with their means, in nanoseconds
+function(read_benchmarks FILE PREFIX)
+    file(READ "${FILE}" content)
+    string(REGEX MATCHALL "<BenchmarkResults name=\"[^\"]*\"[^>]*>[^<]*(<!--[^>]*-->)?[^<]*<mean value=\"[^\"]*\"" matches "${content}")
+    set(names "")
+    set(index 0)
+    foreach (match IN LISTS matches)
+        string(REGEX REPLACE "^<BenchmarkResults name=\"([^\"]*)\".*$" "\\1" name "${match}")
+        string(REGEX REPLACE "^.*<mean value=\"([^\"]*)\"$" "\\1" mean "${match}")
+        list(APPEND names "${name}")
+        set(${PREFIX}_${index} "${mean}" PARENT_SCOPE)
+        math(EXPR index "${index} + 1")
+    endforeach ()
+    set(${PREFIX}_NAMES "${names}" PARENT_SCOPE)
+endfunction()
+
+# Converts a nanoseconds value, possibly in scientific notation, to integer picoseconds, since CMake math only handles integers
+function(to_picoseconds VALUE OUT)
+    set(exponent 0)
+    if (VALUE MATCHES "^([0-9.]+)[eE]([+-]?)0*([0-9]+)$")
+        set(VALUE "${CMAKE_MATCH_1}")
+        set(exponent "${CMAKE_MATCH_2}${CMAKE_MATCH_3}")
+    endif ()
+    set(integral "${VALUE}")
+    set(fraction "")
+    if (VALUE MATCHES "^([0-9]*)\\.([0-9]*)$")
+        set(integral "${CMAKE_MATCH_1}")
+        set(fraction "${CMAKE_MATCH_2}")
+    endif ()
+    string(LENGTH "${fraction}" fraction_length)
+    set(digits "${integral}${fraction}")
+    math(EXPR shift "${exponent} + 3 - ${fraction_length}")
+    if (NOT shift LESS 0)
+        while (shift GREATER 0)
+            string(APPEND digits "0")
+            math(EXPR shift "${shift} - 1")
+        endwhile ()
+    else ()
+        string(LENGTH "${digits}" length)
+        math(EXPR keep "${length} + ${shift}")
+        if (keep GREATER 0)
+            string(SUBSTRING "${digits}" 0 ${keep} digits)
+        else ()
+            set(digits "0")
+        endif ()
+    endif ()
+    if (digits MATCHES "^0+([0-9].*)$")
+        set(digits "${CMAKE_MATCH_1}")
+    endif ()
+    set(${OUT} "${digits}" PARENT_SCOPE)
+endfunction()
+
+read_benchmarks("${RESULTS}" CURRENT)
+read_benchmarks("${BASELINE}" BASE)
+
+set(regressions 0)
+set(index 0)
+foreach (name IN LISTS CURRENT_NAMES)
+    list(FIND BASE_NAMES "${name}" base_index)
+    if (base_index EQUAL -1)
+        message("-- [new] ${name}: ${CURRENT_${index}} ns")
+    else ()
+        set(current "${CURRENT_${index}}")
+        set(base "${BASE_${base_index}}")
+        to_picoseconds("${current}" current_ps)
+        to_picoseconds("${base}" base_ps)
+        math(EXPR allowed "${base_ps} + ${base_ps} * ${TOLERANCE} / 100")
+        if (current_ps GREATER allowed)
+            message("-- [regression] ${name}: ${current} ns, baseline ${base} ns")
+            math(EXPR regressions "${regressions} + 1")
+        else ()
+            message("-- [ok] ${name}: ${current} ns, baseline ${base} ns")
+        endif ()
+    endif ()
+    math(EXPR index "${index} + 1")
+endforeach ()
+
+if (regressions GREATER 0)
+    message(FATAL_ERROR "${regressions} benchmark(s) regressed more than ${TOLERANCE}%")
+endif ()
@@ -0,0 +1,196 @@
+#pragma once
+
+namespace moon {
+/// Memory allocator for a Lua state, passed to lua_newstate. Accounts memory in use by the state and enforces an optional hard limit,
+/// failing allocations cleanly, which Lua reports as a memory error. Default implementation relies on malloc, realloc and free.
+/// An allocator serves a single state, so no locking is done.
+class Allocator {
+public:
+    /// Creates allocator.
+    /// \param limit Maximum number of bytes in use. 0 means no limit.
+    explicit Allocator(size_t limit = 0) : m_limit(limit) {}
+
+    Allocator(const Allocator&) = delete;
+
+    Allocator(Allocator&&) = delete;
+
+    virtual ~Allocator() = default;
+
+    Allocator& operator=(const Allocator&) = delete;
+
+    Allocator& operator=(Allocator&&) = delete;
+
+    /// Allocation function with lua_Alloc signature. User data must be the allocator.
+    static void* Allocate(void* ud, void* ptr, size_t osize, size_t nsize) {
+        auto* self = static_cast<Allocator*>(ud);
+        if (ptr == nullptr) {
+            osize = 0;  // Holds type of object being created
+        }
+        if (nsize == 0) {
+            if (ptr != nullptr) {
+                self->deallocate(ptr, osize);
+                self->m_usage -= osize;
+            }
+            return nullptr;
+        }
+        if (nsize > osize && self->m_limit != 0 && self->m_usage - osize + nsize > self->m_limit) {
+            ++self->m_failures;
+            return nullptr;
+        }
+        void* block = ptr == nullptr ? self->allocate(nsize) : self->reallocate(ptr, osize, nsize);
+        if (block == nullptr) {
+            ++self->m_failures;
+            return nullptr;
+        }
+        if (ptr == nullptr) {
+            ++self->m_allocations;
+        }
+        self->m_usage = self->m_usage - osize + nsize;
+        self->m_peak = std::max(self->m_peak, self->m_usage);
+        return block;
+    }
+
+    /// Getter for number of bytes currently in use.
+    /// \return Memory usage.
+    [[nodiscard]] inline size_t GetUsage() const { return m_usage; }
+
+    /// Getter for maximum number of bytes in use at once.
+    /// \return Peak memory usage.
+    [[nodiscard]] inline size_t GetPeak() const { return m_peak; }
+
+    /// Getter for number of new blocks allocated, excluding resizes.
+    /// \return Number of allocations.
+    [[nodiscard]] inline size_t GetAllocations() const { return m_allocations; }
+
+    /// Getter for number of allocations refused, either by limit or by failing to allocate.
+    /// \return Number of failed allocations.
+    [[nodiscard]] inline size_t GetFailures() const { return m_failures; }
+
+    /// Getter for memory limit.
+    /// \return Memory limit in bytes, 0 if none.
+    [[nodiscard]] inline size_t GetLimit() const { return m_limit; }
+
+    /// Setter for memory limit. Memory already in use is not affected.
+    /// \param limit Memory limit in bytes, 0 for none.
+    inline void SetLimit(size_t limit) { m_limit = limit; }
+
+protected:
+    /// Allocates new block.
+    virtual void* allocate(size_t size) { return std::malloc(size); }
+
+    /// Resizes block. Shrinking must not fail.
+    virtual void* reallocate(void* ptr, size_t, size_t newSize) { return std::realloc(ptr, newSize); }
+
+    /// Frees block.
+    virtual void deallocate(void* ptr, size_t) { std::free(ptr); }
+
+private:
+    /// Memory limit, 0 if none.
+    size_t m_limit{0};
+    /// Bytes in use.
+    size_t m_usage{0};
+    /// Peak bytes in use.
+    size_t m_peak{0};
+    /// New blocks allocated.
+    size_t m_allocations{0};
+    /// Refused allocations.
+    size_t m_failures{0};
+};
+
+/// Size class pool allocator, tuned for the many small allocations of Lua (strings, tables, closures). Small blocks are carved from
+/// large chunks and recycled in a free list per size class, instead of going through malloc. Larger blocks use the default allocator.
+/// Chunks are only released when allocator is destroyed.
+class PoolAllocator : public Allocator {
+public:
+    /// Size class granularity, in bytes. Also the alignment of pooled blocks.
+    static constexpr size_t s_granularity{16};
+    /// Largest pooled block size.
+    static constexpr size_t s_maxBlockSize{256};
+    /// Size of chunks blocks are carved from.
+    static constexpr size_t s_chunkSize{64 * 1024};
+
+    explicit PoolAllocator(size_t limit = 0) : Allocator(limit) {}
+
+    ~PoolAllocator() override {
+        for (void* chunk : m_chunks) {
+            std::free(chunk);
+        }
+    }
+
+    /// Getter for number of chunks allocated.
+    /// \return Number of chunks.
+    [[nodiscard]] inline size_t GetChunkCount() const { return m_chunks.size(); }
+
+protected:
+    void* allocate(size_t size) override {
+        if (size > s_maxBlockSize) {
+            return Allocator::allocate(size);
+        }
+        size_t index = classOf(size);
+        if (m_free[index] != nullptr) {
+            Block* block = m_free[index];
+            m_free[index] = block->next;
+            return block;
+        }
+        size_t blockSize = (index + 1) * s_granularity;
+        if (m_cursor == nullptr || (size_t)(m_end - m_cursor) < blockSize) {
+            auto* chunk = static_cast<char*>(std::malloc(s_chunkSize));
+            if (chunk == nullptr) {
+                return nullptr;
+            }
+            m_chunks.push_back(chunk);
+            m_cursor = chunk;
+            m_end = chunk + s_chunkSize;
+        }
+        void* block = m_cursor;
+        m_cursor += blockSize;
+        return block;
+    }
+
+    void* reallocate(void* ptr, size_t oldSize, size_t newSize) override {
+        if (oldSize > s_maxBlockSize && newSize > s_maxBlockSize) {
+            return Allocator::reallocate(ptr, oldSize, newSize);
+        }
+        if (oldSize <= s_maxBlockSize && newSize <= s_maxBlockSize && classOf(oldSize) == classOf(newSize)) {
+            return ptr;
+        }
+        void* block = allocate(newSize);
+        if (block == nullptr) {
+            // Shrinking must not fail, so block is kept. Freed with its new size, it joins free list of that class, larger blocks too.
+            return newSize <= oldSize ? ptr : nullptr;
+        }
+        std::memcpy(block, ptr, std::min(oldSize, newSize));
+        deallocate(ptr, oldSize);
+        return block;
+    }
+
+    void deallocate(void* ptr, size_t size) override {
+        if (size > s_maxBlockSize) {
+            Allocator::deallocate(ptr, size);
+            return;
+        }
+        size_t index = classOf(size);
+        auto* block = static_cast<Block*>(ptr);
+        block->next = m_free[index];
+        m_free[index] = block;
+    }
+
+private:
+    /// Free list node, stored in free blocks.
+    struct Block {
+        Block* next;
+    };
+
+    /// Size class index of block size.
+    static constexpr size_t classOf(size_t size) { return (size + s_granularity - 1) / s_granularity - 1; }
+
+    /// Free lists per size class.
+    std::array<Block*, s_maxBlockSize / s_granularity> m_free{};
+    /// Allocated chunks.
+    std::vector<void*> m_chunks;
+    /// Next free byte in current chunk.
+    char* m_cursor{nullptr};
+    /// End of current chunk.
+    char* m_end{nullptr};
+};
+}  // namespace moon
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "function.h"
+
+namespace moon {
+/// How a callback runs its Lua function.
+enum class CallbackMode {
+    /// Runs in protected mode, logging errors and returning default constructed values.
+    Protected,
+    /// Runs unprotected, so errors propagate as Lua errors to the enclosing protected call. Only for trusted callbacks called while Lua is
+    /// running, e.g. from a C++ function called by Lua, since an unprotected error with nothing to catch it panics. Unless Lua is built as
+    /// C++, errors also skip destructors of C++ frames in between.
+    Unprotected
+};
+
+template <typename Signature>
+class Callback;
+
+/// Lightweight handle to a Lua function, meant to be stored by the thousands and called often, e.g. by event systems. Holds only a state
+/// pointer, a registry key and a mode, inline and with no type erasure, so it never allocates besides its registry slot. Unlike
+/// moon::Function, it is copyable, each copy holding its own registry slot, and can be received as argument of registered C++ functions.
+/// Calls fetch function straight from registry and skip the traceback handler, and can skip protected mode entirely for trusted callbacks.
+/// \tparam Ret Return type. Void, single type or tuple for multiple returns.
+/// \tparam Args Arguments types.
+template <typename Ret, typename... Args>
+class Callback<Ret(Args...)> : public Reference {
+public:
+    Callback() = default;
+
+    /// Creates a callback of function at index in stack. Logs an error if value is not a function.
+    /// \param L Lua state.
+    /// \param index Index of function in stack.
+    /// \param mode Whether or not calls run in protected mode.
+    Callback(lua_State* L, int index, CallbackMode mode = CallbackMode::Protected) : m_state(L), m_mode(mode) {
+        if (!lua_isfunction(L, index)) {
+            Logger::Error("tried to create a Callback from a value that is not a function");
+            return;
+        }
+        lua_pushvalue(L, index);
+        m_key = luaL_ref(L, LUA_REGISTRYINDEX);
+    }
+
+    Callback(const Callback& other) : m_state(other.m_state), m_mode(other.m_mode) {
+        if (other.IsLoaded()) {
+            lua_rawgeti(m_state, LUA_REGISTRYINDEX, other.m_key);
+            m_key = luaL_ref(m_state, LUA_REGISTRYINDEX);
+        }
+    }
+
+    Callback(Callback&& other) noexcept : Reference(std::move(other)), m_state(other.m_state), m_mode(other.m_mode) {
+        other.m_state = nullptr;
+    }
+
+    ~Callback() {
+        if (m_state == nullptr) {
+            return;
+        }
+        Unload(m_state);
+    }
+
+    Callback& operator=(const Callback& other) {
+        if (&other == this) {
+            return *this;
+        }
+        Callback copy{other};
+        return *this = std::move(copy);
+    }
+
+    Callback& operator=(Callback&& other) noexcept {
+        if (&other == this) {
+            return *this;
+        }
+        if (m_state != nullptr) {
+            Unload(m_state);
+        }
+        m_key = other.m_key;
+        m_state = other.m_state;
+        m_mode = other.m_mode;
+        other.m_key = LUA_NOREF;
+        other.m_state = nullptr;
+        return *this;
+    }
+
+    /// Will save function at top of stack as callback and pop it.
+    /// \param L Lua state.
+    /// \param mode Whether or not calls run in protected mode.
+    /// \return Callback.
+    static Callback CreateAndPop(lua_State* L, CallbackMode mode = CallbackMode::Protected) {
+        Callback callback{L, -1, mode};
+        lua_pop(L, 1);
+        return callback;
+    }
+
+    /// Getter for the Lua state.
+    /// \return Lua state pointer.
+    [[nodiscard]] inline lua_State* GetState() const { return m_state; }
+
+    /// Getter for call mode.
+    /// \return Whether or not calls run in protected mode.
+    [[nodiscard]] inline CallbackMode GetMode() const { return m_mode; }
+
+    /// Setter for call mode, e.g. to trust a callback received from Lua.
+    /// \param mode Whether or not calls run in protected mode.
+    inline void SetMode(CallbackMode mode) { m_mode = mode; }
+
+    explicit operator bool() const { return IsLoaded(); }
+
+    /// Calls Lua function. In protected mode, errors are logged and a default constructed value is returned.
+    /// \param args Arguments to pass to function.
+    /// \return Returned value(s) from Lua function.
+    Ret operator()(Args... args) const {
+        if (!IsLoaded()) {
+            return Stack::DefaultReturnWithError<Ret>("tried to call a Callback not loaded");
+        }
+        int base = lua_gettop(m_state);
+        lua_rawgeti(m_state, LUA_REGISTRYINDEX, m_key);
+        (Core::Push(m_state, std::forward<Args>(args)), ...);
+        if (m_mode == CallbackMode::Unprotected) {
+            lua_call(m_state, (int)meta::count_expected_v<Args...>, results());
+        } else if (lua_pcall(m_state, (int)meta::count_expected_v<Args...>, results(), 0) != LUA_OK) {
+            const char* msg = lua_tostring(m_state, -1);
+            std::string error{msg != nullptr ? msg : "error calling Callback"};
+            lua_settop(m_state, base);
+            return Stack::DefaultReturnWithError<Ret>(std::move(error));
+        }
+        if constexpr (std::is_void_v<Ret>) {
+            lua_settop(m_state, base);
+        } else {
+            Ret ret = Stack::GetValue<Ret>(m_state, -1);
+            lua_settop(m_state, base);
+            return ret;
+        }
+    }
+
+private:
+    /// Number of results expected from Lua function.
+    static constexpr int results() {
+        if constexpr (std::is_void_v<Ret>) {
+            return 0;
+        } else {
+            return (int)meta::count_expected_v<Ret>;
+        }
+    }
+
+    /// Lua state.
+    lua_State* m_state{nullptr};
+    /// Whether or not calls run in protected mode.
+    CallbackMode m_mode{CallbackMode::Protected};
+};
+}  // namespace moon
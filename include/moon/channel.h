@@ -0,0 +1,340 @@
+#pragma once
+
+#include "serializer.h"
+
+namespace moon {
+constexpr const char* LUA_CHANNEL_META_NAME{"MoonChannel"};
+
+/// Bounded multi producer, multi consumer queue of messages between Lua states living in different threads, e.g. stages of a pipeline.
+/// Lua values are carried encoded by moon::Serializer, so sender and receiver states share nothing. Slots are preallocated and their buffers
+/// swapped in and out, so steady messaging reuses memory. Locking is limited to moving a buffer in or out of a slot, encoding and decoding
+/// happen outside of it. Exposed to Lua as userdata with Send, TrySend, Receive, TryReceive and Close methods. Inside a coroutine, Send
+/// and Receive yield a readiness check instead of blocking, so moon::Scheduler keeps running other coroutines meanwhile.
+class Channel {
+public:
+    /// Creates an open channel.
+    /// \param capacity Maximum number of pending messages. At least 1.
+    explicit Channel(size_t capacity) : m_slots(std::max(capacity, (size_t)1)) {}
+
+    Channel(const Channel&) = delete;
+
+    Channel(Channel&&) = delete;
+
+    ~Channel() = default;
+
+    Channel& operator=(const Channel&) = delete;
+
+    Channel& operator=(Channel&&) = delete;
+
+    /// Sends an encoded message, blocking while channel is full. Message buffer is swapped with a spare one, left empty.
+    /// \param message Message to send.
+    /// \return Whether or not message was sent, false if channel is closed.
+    bool Send(std::vector<uint8_t>& message) {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_notFull.wait(lock, [this]() { return m_closed || m_size < m_slots.size(); });
+        return push(lock, message);
+    }
+
+    /// Sends an encoded message without blocking. Message buffer is swapped with a spare one, left empty, only if sent.
+    /// \param message Message to send.
+    /// \return Whether or not message was sent, false if channel is full or closed.
+    bool TrySend(std::vector<uint8_t>& message) {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        return push(lock, message);
+    }
+
+    /// Receives an encoded message, blocking while channel is empty. Pending messages can still be received after channel is closed.
+    /// \param message Buffer swapped with message received.
+    /// \return Whether or not a message was received, false if channel is closed and empty.
+    bool Receive(std::vector<uint8_t>& message) {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_notEmpty.wait(lock, [this]() { return m_closed || m_size > 0; });
+        return pop(lock, message);
+    }
+
+    /// Receives an encoded message without blocking.
+    /// \param message Buffer swapped with message received.
+    /// \return Whether or not a message was received, false if channel is empty.
+    bool TryReceive(std::vector<uint8_t>& message) {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        return pop(lock, message);
+    }
+
+    /// Encodes value at index and sends it, blocking while channel is full.
+    /// \param L Lua state.
+    /// \param index Index of value in stack.
+    /// \return Whether or not value was sent.
+    bool Send(lua_State* L, int index) {
+        auto& buffer = scratch();
+        return Serializer::Encode(L, index, buffer) && Send(buffer);
+    }
+
+    /// Encodes value at index and sends it without blocking.
+    /// \param L Lua state.
+    /// \param index Index of value in stack.
+    /// \return Whether or not value was sent.
+    bool TrySend(lua_State* L, int index) {
+        auto& buffer = scratch();
+        return Serializer::Encode(L, index, buffer) && TrySend(buffer);
+    }
+
+    /// Receives a value and pushes it to stack, blocking while channel is empty. Nothing is pushed if no value is received.
+    /// \param L Lua state.
+    /// \return Whether or not a value was received.
+    bool Receive(lua_State* L) {
+        auto& buffer = scratch();
+        return Receive(buffer) && Serializer::Decode(L, buffer.data(), buffer.size()) > 0;
+    }
+
+    /// Receives a value and pushes it to stack without blocking. Nothing is pushed if no value is received.
+    /// \param L Lua state.
+    /// \return Whether or not a value was received.
+    bool TryReceive(lua_State* L) {
+        auto& buffer = scratch();
+        return TryReceive(buffer) && Serializer::Decode(L, buffer.data(), buffer.size()) > 0;
+    }
+
+    /// Closes channel, waking every blocked sender and receiver. Further sends fail, pending messages can still be received.
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_closed = true;
+        }
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+
+    /// Checks if channel was closed.
+    /// \return Whether or not channel is closed.
+    [[nodiscard]] bool IsClosed() const {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        return m_closed;
+    }
+
+    /// Checks if a send would not block, either because there is room or because channel is closed.
+    /// \return Whether or not sending is ready.
+    [[nodiscard]] bool CanSend() const {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        return m_closed || m_size < m_slots.size();
+    }
+
+    /// Checks if a receive would not block, either because a message is pending or because channel is closed.
+    /// \return Whether or not receiving is ready.
+    [[nodiscard]] bool CanReceive() const {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        return m_closed || m_size > 0;
+    }
+
+    /// Getter for number of pending messages.
+    /// \return Number of messages.
+    [[nodiscard]] size_t GetSize() const {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        return m_size;
+    }
+
+    /// Getter for maximum number of pending messages.
+    /// \return Capacity.
+    [[nodiscard]] inline size_t GetCapacity() const { return m_slots.size(); }
+
+    /// Pushes channel to stack as userdata sharing its ownership, so each state can hold the same channel.
+    /// \param L Lua state.
+    /// \param channel Channel to push.
+    static void Push(lua_State* L, std::shared_ptr<Channel> channel) {
+        if (!channel) {
+            Logger::Error("tried to push a null Channel");
+            lua_pushnil(L);
+            return;
+        }
+        new (lua_newuserdatauv(L, sizeof(std::shared_ptr<Channel>), 0)) std::shared_ptr<Channel>{std::move(channel)};
+        if (luaL_newmetatable(L, LUA_CHANNEL_META_NAME) != 0) {
+            registerMethods(L);
+        }
+        lua_setmetatable(L, -2);
+    }
+
+    /// Getter for channel held by userdata at index.
+    /// \param L Lua state.
+    /// \param index Index of userdata in stack.
+    /// \return Channel, null if value is not a channel.
+    static std::shared_ptr<Channel> Get(lua_State* L, int index) {
+        auto* channel = static_cast<std::shared_ptr<Channel>*>(luaL_testudata(L, index, LUA_CHANNEL_META_NAME));
+        if (channel == nullptr) {
+            return Stack::DefaultReturnWithError<std::shared_ptr<Channel>>("value is not a Channel");
+        }
+        return *channel;
+    }
+
+private:
+    /// Moves message into next free slot, notifying a receiver. Must be called with mutex locked.
+    bool push(std::unique_lock<std::mutex>& lock, std::vector<uint8_t>& message) {
+        if (m_closed || m_size == m_slots.size()) {
+            return false;
+        }
+        auto& slot = m_slots[(m_head + m_size) % m_slots.size()];
+        slot.swap(message);
+        message.clear();
+        ++m_size;
+        lock.unlock();
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    /// Moves message out of oldest slot, notifying a sender. Must be called with mutex locked.
+    bool pop(std::unique_lock<std::mutex>& lock, std::vector<uint8_t>& message) {
+        if (m_size == 0) {
+            return false;
+        }
+        m_slots[m_head].swap(message);
+        m_head = (m_head + 1) % m_slots.size();
+        --m_size;
+        lock.unlock();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    /// Buffer used to encode and decode values, kept per thread to reuse its storage.
+    static std::vector<uint8_t>& scratch() {
+        thread_local std::vector<uint8_t> buffer;
+        buffer.clear();
+        return buffer;
+    }
+
+    static void registerMethods(lua_State* L) {
+        lua_pushvalue(L, -1);
+        lua_setfield(L, -2, "__index");
+        lua_pushcfunction(L, &Channel::gc);
+        lua_setfield(L, -2, "__gc");
+        lua_pushcfunction(L, &Channel::send);
+        lua_setfield(L, -2, "Send");
+        lua_pushcfunction(L, &Channel::trySend);
+        lua_setfield(L, -2, "TrySend");
+        lua_pushcfunction(L, &Channel::receive);
+        lua_setfield(L, -2, "Receive");
+        lua_pushcfunction(L, &Channel::tryReceive);
+        lua_setfield(L, -2, "TryReceive");
+        lua_pushcfunction(L, &Channel::close);
+        lua_setfield(L, -2, "Close");
+        lua_pushcfunction(L, &Channel::isClosed);
+        lua_setfield(L, -2, "IsClosed");
+        lua_pushcfunction(L, &Channel::size);
+        lua_setfield(L, -2, "__len");
+    }
+
+    static Channel& self(lua_State* L, int index) {
+        return **static_cast<std::shared_ptr<Channel>*>(luaL_checkudata(L, index, LUA_CHANNEL_META_NAME));
+    }
+
+    /// Yields a readiness check of channel at index 1, resuming in continuation once scheduler finds it ready.
+    static int yield(lua_State* L, lua_CFunction ready, lua_KFunction continuation) {
+        lua_pushvalue(L, 1);
+        lua_pushcclosure(L, ready, 1);
+        return lua_yieldk(L, 1, 0, continuation);
+    }
+
+    static int canSend(lua_State* L) {
+        lua_pushboolean(L, self(L, lua_upvalueindex(1)).CanSend());
+        return 1;
+    }
+
+    static int canReceive(lua_State* L) {
+        lua_pushboolean(L, self(L, lua_upvalueindex(1)).CanReceive());
+        return 1;
+    }
+
+    /// channel:Send(value) -> sent. Yields while full inside a coroutine, blocks otherwise.
+    static int send(lua_State* L) { return sendContinue(L, LUA_OK, 0); }
+
+    static int sendContinue(lua_State* L, int, lua_KContext) {
+        lua_settop(L, 2);
+        auto& channel = self(L, 1);
+        if (!lua_isyieldable(L)) {
+            lua_pushboolean(L, channel.Send(L, 2));
+            return 1;
+        }
+        auto& buffer = scratch();
+        if (!Serializer::Encode(L, 2, buffer)) {
+            lua_pushboolean(L, false);
+            return 1;
+        }
+        bool sent = channel.TrySend(buffer);
+        if (!sent && !channel.IsClosed()) {
+            return yield(L, &Channel::canSend, &Channel::sendContinue);
+        }
+        lua_pushboolean(L, sent);
+        return 1;
+    }
+
+    /// channel:TrySend(value) -> sent.
+    static int trySend(lua_State* L) {
+        lua_pushboolean(L, self(L, 1).TrySend(L, 2));
+        return 1;
+    }
+
+    /// channel:Receive() -> received, value. Yields while empty inside a coroutine, blocks otherwise.
+    static int receive(lua_State* L) { return receiveContinue(L, LUA_OK, 0); }
+
+    static int receiveContinue(lua_State* L, int, lua_KContext) {
+        lua_settop(L, 1);
+        auto& channel = self(L, 1);
+        auto& buffer = scratch();
+        bool yieldable = lua_isyieldable(L) != 0;
+        bool received = yieldable ? channel.TryReceive(buffer) : channel.Receive(buffer);
+        if (!received && yieldable && !channel.IsClosed()) {
+            return yield(L, &Channel::canReceive, &Channel::receiveContinue);
+        }
+        return pushReceived(L, received, buffer);
+    }
+
+    /// channel:TryReceive() -> received, value.
+    static int tryReceive(lua_State* L) {
+        auto& buffer = scratch();
+        bool received = self(L, 1).TryReceive(buffer);
+        return pushReceived(L, received, buffer);
+    }
+
+    static int pushReceived(lua_State* L, bool received, const std::vector<uint8_t>& buffer) {
+        if (!received || Serializer::Decode(L, buffer.data(), buffer.size()) == 0) {
+            lua_pushboolean(L, false);
+            return 1;
+        }
+        lua_pushboolean(L, true);
+        lua_insert(L, -2);
+        return 2;
+    }
+
+    static int close(lua_State* L) {
+        self(L, 1).Close();
+        return 0;
+    }
+
+    static int isClosed(lua_State* L) {
+        lua_pushboolean(L, self(L, 1).IsClosed());
+        return 1;
+    }
+
+    static int size(lua_State* L) {
+        lua_pushinteger(L, (lua_Integer)self(L, 1).GetSize());
+        return 1;
+    }
+
+    static int gc(lua_State* L) {
+        static_cast<std::shared_ptr<Channel>*>(lua_touserdata(L, 1))->~shared_ptr();
+        return 0;
+    }
+
+    /// Message slots, used as ring buffer.
+    std::vector<std::vector<uint8_t>> m_slots;
+    /// Index of oldest pending message.
+    size_t m_head{0};
+    /// Number of pending messages.
+    size_t m_size{0};
+    /// Whether or not channel was closed.
+    bool m_closed{false};
+    /// Guards slots and counters.
+    mutable std::mutex m_mutex;
+    /// Signals room to send.
+    std::condition_variable m_notFull;
+    /// Signals messages to receive.
+    std::condition_variable m_notEmpty;
+};
+}  // namespace moon
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "object.h"
+
+namespace moon {
+/// Compiled Lua chunk, kept in registry as a reference to the loaded function. Can be ran multiple times without being parsed again and
+/// dumped to/loaded from precompiled bytecode.
+class Chunk : public Reference {
+public:
+    Chunk() = default;
+
+    Chunk(const Chunk&) = delete;
+
+    Chunk(Chunk&& other) noexcept : Reference(std::move(other)), m_state(other.m_state) { other.m_state = nullptr; }
+
+    ~Chunk() {
+        if (m_state == nullptr) {
+            return;
+        }
+        Unload(m_state);
+    }
+
+    Chunk& operator=(const Chunk&) = delete;
+
+    Chunk& operator=(Chunk&& other) noexcept {
+        if (&other == this) {
+            return *this;
+        }
+        if (m_state != nullptr) {
+            Unload(m_state);
+        }
+        m_key = other.m_key;
+        m_state = other.m_state;
+        other.m_key = LUA_NOREF;
+        other.m_state = nullptr;
+        return *this;
+    }
+
+    /// Compiles Lua code, source or precompiled, without running it. Logs an error if it fails to compile.
+    /// \param L Lua state.
+    /// \param code Code to compile.
+    /// \param size Code size in bytes.
+    /// \param name Chunk name, used in error messages.
+    /// \param mode Whether chunk can be text ("t"), binary ("b") or both ("bt").
+    /// \return Compiled chunk. Not loaded on errors.
+    static Chunk FromBuffer(lua_State* L, const char* code, size_t size, const char* name, const char* mode = "bt") {
+        return {L, luaL_loadbufferx(L, code, size, name, mode), "Error compiling code"};
+    }
+
+    /// Compiles Lua source code snippet without running it.
+    /// \param L Lua state.
+    /// \param code Code to compile.
+    /// \return Compiled chunk. Not loaded on errors.
+    static Chunk FromCode(lua_State* L, const char* code) { return FromBuffer(L, code, strlen(code), code, "t"); }
+
+    /// Compiles Lua precompiled bytecode, obtained with Dump.
+    /// \param L Lua state.
+    /// \param bytecode Bytecode to load.
+    /// \return Compiled chunk. Not loaded on errors.
+    static Chunk FromBytecode(lua_State* L, const std::string& bytecode) {
+        return FromBuffer(L, bytecode.data(), bytecode.size(), "=bytecode", "b");
+    }
+
+    /// Compiles Lua file, source or precompiled, without running it.
+    /// \param L Lua state.
+    /// \param filePath File path to load.
+    /// \return Compiled chunk. Not loaded on errors.
+    static Chunk FromFile(lua_State* L, const char* filePath) { return {L, luaL_loadfile(L, filePath), "Error loading file"}; }
+
+    /// Getter for the Lua state.
+    /// \return Lua state pointer.
+    [[nodiscard]] inline lua_State* GetState() const { return m_state; }
+
+    /// Runs compiled chunk in protected mode. Returned values are left in stack, as in Moon::RunCode.
+    /// \param results Number of results to leave in stack. Defaults to all.
+    /// \return Whether or not chunk ran without errors.
+    bool Run(int results = LUA_MULTRET) const {
+        if (!IsLoaded()) {
+            Logger::Error("tried to run a chunk not loaded");
+            return false;
+        }
+        Reference::Push(m_state);
+        return checkStatus(m_state, lua_pcall(m_state, 0, results, 0), "Running chunk failed");
+    }
+
+    /// Dumps compiled chunk as precompiled bytecode, which can be stored and loaded later with FromBytecode.
+    /// \param strip Whether or not to strip debug information.
+    /// \return Bytecode. Empty if chunk is not loaded.
+    [[nodiscard]] std::string Dump(bool strip = false) const {
+        std::string bytecode;
+        if (!IsLoaded()) {
+            return bytecode;
+        }
+        Reference::Push(m_state);
+        lua_dump(m_state, &Chunk::writer, &bytecode, strip ? 1 : 0);
+        lua_pop(m_state, 1);
+        return bytecode;
+    }
+
+private:
+    /// Stores compiled function at top of stack as reference, when status is ok.
+    Chunk(lua_State* L, int status, const char* errMessage) : m_state(L) {
+        if (checkStatus(L, status, errMessage)) {
+            m_key = luaL_ref(L, LUA_REGISTRYINDEX);
+        }
+    }
+
+    /// Checks for lua status, logging error found in stack.
+    static bool checkStatus(lua_State* L, int status, const char* errMessage) {
+        if (status != LUA_OK) {
+            const auto* msg = lua_tostring(L, -1);
+            Logger::Error(msg != nullptr ? msg : errMessage);
+            lua_pop(L, 1);
+            return false;
+        }
+        return true;
+    }
+
+    /// Writer used in lua_dump, appends to string buffer.
+    static int writer(lua_State*, const void* data, size_t size, void* buffer) {
+        static_cast<std::string*>(buffer)->append(static_cast<const char*>(data), size);
+        return 0;
+    }
+
+    /// Lua state.
+    lua_State* m_state{nullptr};
+};
+
+/// Cache of compiled chunks, keyed by source code or by file path. Files are recompiled when their modification time or size changes.
+class ChunkCache {
+public:
+    ChunkCache() = default;
+
+    explicit ChunkCache(lua_State* L) : m_state(L) {}
+
+    /// Gets compiled chunk for source code, compiling it only if not cached.
+    /// \param code Source code.
+    /// \return Cached chunk. Nullptr if code fails to compile.
+    const Chunk* GetCode(const char* code) {
+        auto it = m_code.find(code);
+        if (it != m_code.end()) {
+            return &it->second;
+        }
+        auto chunk = Chunk::FromCode(m_state, code);
+        if (!chunk.IsLoaded()) {
+            return nullptr;
+        }
+        return &m_code.emplace(code, std::move(chunk)).first->second;
+    }
+
+    /// Gets compiled chunk for file, compiling it only if not cached or if file was modified.
+    /// \param filePath File path.
+    /// \return Cached chunk. Nullptr if file fails to load.
+    const Chunk* GetFile(const char* filePath) {
+        struct stat info {};
+        if (stat(filePath, &info) != 0) {
+            Logger::Error(std::string("cannot open ").append(filePath));
+            return nullptr;
+        }
+        auto it = m_files.find(filePath);
+        if (it != m_files.end()) {
+            if (!isStale(it->second, info)) {
+                return &it->second.chunk;
+            }
+            m_files.erase(it);
+        }
+        auto chunk = Chunk::FromFile(m_state, filePath);
+        if (!chunk.IsLoaded()) {
+            return nullptr;
+        }
+        return &m_files.emplace(filePath, FileEntry{std::move(chunk), info.st_mtime, nanoseconds(info), (long long)info.st_size}).first->second.chunk;
+    }
+
+    /// Checks if file would be compiled again by GetFile, because it is not cached yet or was modified since.
+    /// \param filePath File path.
+    /// \return Whether or not file is missing from cache or out of date.
+    [[nodiscard]] bool IsModified(const char* filePath) const {
+        struct stat info {};
+        if (stat(filePath, &info) != 0) {
+            return true;
+        }
+        auto it = m_files.find(filePath);
+        return it == m_files.end() || isStale(it->second, info);
+    }
+
+    /// Getter for number of cached chunks.
+    /// \return Number of chunks.
+    [[nodiscard]] inline size_t GetSize() const { return m_code.size() + m_files.size(); }
+
+    /// Removes all chunks from cache, releasing their references.
+    void Clear() {
+        m_code.clear();
+        m_files.clear();
+    }
+
+private:
+    /// Cached file chunk along with file stats at compile time.
+    struct FileEntry {
+        Chunk chunk;
+        time_t modified;
+        long long nanoseconds;
+        long long size;
+    };
+
+    /// Sub second part of file modification time, where file system and platform expose it, so edits within a second are detected.
+    static inline long long nanoseconds(const struct stat& info) {
+#if defined(__APPLE__)
+        return (long long)info.st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+        (void)info;
+        return 0;
+#else
+        return (long long)info.st_mtim.tv_nsec;
+#endif
+    }
+
+    /// Checks if cached entry is out of date with file stats.
+    static inline bool isStale(const FileEntry& entry, const struct stat& info) {
+        return entry.modified != info.st_mtime || entry.nanoseconds != nanoseconds(info) || entry.size != (long long)info.st_size;
+    }
+
+    /// Lua state.
+    lua_State* m_state{nullptr};
+    /// Chunks compiled from source code.
+    std::unordered_map<std::string, Chunk> m_code;
+    /// Chunks compiled from files.
+    std::unordered_map<std::string, FileEntry> m_files;
+};
+}  // namespace moon
@@ -53,14 +53,14 @@ public:
         /// \return Number of elements to be popped from stack.
         template <FieldMode mode = FieldMode::None>
         int Get(lua_State* L, int, Key&& key) {
-            if constexpr (meta::is_basic_string_v<Key>) {
-                lua_getglobal(L, &key[0]);
+            if constexpr (meta::is_basic_string_v<Key> || meta::is_interned_key_v<Key>) {
+                Stack::PushGlobal(L, key);
                 if constexpr (mode & FieldMode::Create) {
                     if (lua_isnil(L, -1)) {
                         lua_pop(L, 1);
                         lua_newtable(L);
-                        lua_setglobal(L, &key[0]);
-                        lua_getglobal(L, &key[0]);
+                        Stack::SetGlobal(L, key);
+                        Stack::PushGlobal(L, key);
                     }
                 }
             } else if constexpr (meta::is_integral_v<Key>) {
@@ -74,8 +74,8 @@ public:
         /// \param key Key (name) to set global. Must be string.
         /// \return Number of elements to pop from stack. Always 0.
         int Set(lua_State* L, int, Key&& key) {
-            static_assert(meta::is_basic_string_v<Key>, "setting a global directly by stack index is forbidden");
-            lua_setglobal(L, &key[0]);
+            static_assert(meta::is_basic_string_v<Key> || meta::is_interned_key_v<Key>, "setting a global directly by stack index is forbidden");
+            Stack::SetGlobal(L, key);
             return 0;
         }
     };
@@ -106,6 +106,27 @@ public:
         return get<global, std::decay_t<Ret>>(L, std::forward<Keys>(keys)...);
     }
 
+    /// Gets sibling fields of table at index, with a single push of each field and no lookup of the table itself.
+    template <typename... Rets, typename... Keys>
+    static decltype(auto) GetFields(lua_State* L, int index, Keys&&... keys) {
+        static_assert(sizeof...(Rets) == sizeof...(Keys), "number of returns and keys must match");
+        if (!lua_istable(L, index)) {
+            return DefaultReturnWithError<std::decay_t<Rets>...>("tried to get fields of a value that is not a table");
+        }
+        index = lua_absindex(L, index);
+        if constexpr (sizeof...(Rets) == 1) {
+            return getField<std::decay_t<Rets>...>(L, index, std::forward<Keys>(keys)...);
+        } else {
+            // Braced initialization reads fields in order
+            return std::tuple<std::decay_t<Rets>...>{getField<std::decay_t<Rets>>(L, index, std::forward<Keys>(keys))...};
+        }
+    }
+
+    template <typename Ret, bool global = true, typename... Keys>
+    static Expected<std::decay_t<Ret>> TryGet(lua_State* L, Keys&&... keys) {
+        return tryGet<global, std::decay_t<Ret>>(L, std::forward<Keys>(keys)...);
+    }
+
     template <typename... Pairs>
     static void Set(lua_State* L, Pairs&&... pairs) {
         static_assert(sizeof...(Pairs) % 2 == 0, "pushing globals only works with name/value pairs");
@@ -128,8 +149,12 @@ public:
 
     template <typename Func>
     static void PushFunction(lua_State* L, Func&& func) {
-        auto deduced = std::function{std::forward<Func>(func)};
-        PushUserData(L, new InvokableSTLFunction(deduced), LUA_INVOKABLE_HOLDER_META_NAME);
+        Invokable::Push(L, std::forward<Func>(func));
+    }
+
+    template <auto func>
+    static void PushFunction(lua_State* L) {
+        Invokable::Push<func>(L);
     }
 
     template <typename T>
@@ -217,6 +242,29 @@ private:
         }
     }
 
+    /// Same path as get, but no error is logged when a table along it is missing.
+    template <bool first, typename Ret, typename Key, typename... Keys>
+    static Expected<Ret> tryGet(lua_State* L, Key&& key, Keys&&... keys) {
+        if constexpr (!first) {
+            if (!lua_istable(L, -1)) {
+                return lua_isnil(L, -1) ? ValueError::Missing : ValueError::TypeMismatch;
+            }
+        }
+        Stack::PopGuard guard{L, FieldHandler<first, Key>{}.Get(L, -1, std::forward<Key>(key))};
+        if constexpr (meta::sizeof_is_v<0, Keys...>) {
+            return Stack::TryGetValue<Ret>(L, -1);
+        } else {
+            return tryGet<false, Ret>(L, std::forward<Keys>(keys)...);
+        }
+    }
+
+    template <typename Ret, typename Key>
+    static Ret getField(lua_State* L, int index, Key&& key) {
+        Stack::PushField(L, index, std::forward<Key>(key));
+        Stack::PopGuard guard{L};
+        return Stack::GetValue<Ret>(L, -1);
+    }
+
     template <typename Ret, typename Key>
     static decltype(auto) getMaybeTuple(lua_State* L, Key&& key) {
         if constexpr (meta::is_tuple_v<Ret>) {
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "function.h"
+
+namespace moon {
+/// Status of a coroutine after being resumed.
+enum class CoroutineStatus { Suspended, Finished, Error };
+
+/// Lua coroutine, running a function in its own Lua thread. Thread is kept as registry reference, so it is not collected while in use.
+/// Values yielded or returned are left in thread stack, until next resume.
+class Coroutine : public Reference {
+public:
+    Coroutine() = default;
+
+    /// Creates a coroutine that runs function at index in stack. Logs an error if value is not a function.
+    /// \param L Lua state.
+    /// \param index Index of function in stack.
+    Coroutine(lua_State* L, int index) : m_state(L) {
+        if (!lua_isfunction(L, index)) {
+            Logger::Error("tried to create a Coroutine from a value that is not a function");
+            m_status = CoroutineStatus::Error;
+            return;
+        }
+        index = lua_absindex(L, index);
+        m_thread = lua_newthread(L);
+        m_key = luaL_ref(L, LUA_REGISTRYINDEX);
+        lua_pushvalue(L, index);
+        lua_xmove(L, m_thread, 1);
+    }
+
+    Coroutine(const Coroutine&) = delete;
+
+    Coroutine(Coroutine&& other) noexcept
+        : Reference(std::move(other)), m_state(other.m_state), m_thread(other.m_thread), m_results(other.m_results), m_status(other.m_status) {
+        other.m_state = nullptr;
+        other.m_thread = nullptr;
+        other.m_results = 0;
+    }
+
+    ~Coroutine() {
+        if (m_state == nullptr) {
+            return;
+        }
+        Unload(m_state);
+    }
+
+    Coroutine& operator=(const Coroutine&) = delete;
+
+    Coroutine& operator=(Coroutine&& other) noexcept {
+        if (&other == this) {
+            return *this;
+        }
+        if (m_state != nullptr) {
+            Unload(m_state);
+        }
+        m_key = other.m_key;
+        m_state = other.m_state;
+        m_thread = other.m_thread;
+        m_results = other.m_results;
+        m_status = other.m_status;
+        other.m_key = LUA_NOREF;
+        other.m_state = nullptr;
+        other.m_thread = nullptr;
+        other.m_results = 0;
+        return *this;
+    }
+
+    /// Will create coroutine from function at top of stack and pop it.
+    /// \param L Lua state.
+    /// \return Coroutine.
+    static Coroutine CreateAndPop(lua_State* L) {
+        Coroutine coroutine{L, -1};
+        lua_pop(L, 1);
+        return coroutine;
+    }
+
+    /// Getter for the Lua state coroutine was created from.
+    /// \return Lua state pointer.
+    [[nodiscard]] inline lua_State* GetState() const { return m_state; }
+
+    /// Getter for coroutine own Lua thread.
+    /// \return Lua thread pointer.
+    [[nodiscard]] inline lua_State* GetThread() const { return m_thread; }
+
+    /// Getter for current status.
+    /// \return Coroutine status.
+    [[nodiscard]] inline CoroutineStatus GetStatus() const { return m_status; }
+
+    /// Checks if coroutine can still be resumed.
+    /// \return Whether or not coroutine finished or failed.
+    [[nodiscard]] inline bool IsDone() const { return m_status != CoroutineStatus::Suspended || !IsLoaded(); }
+
+    /// Getter for number of values yielded or returned by last resume.
+    /// \return Number of results in thread stack.
+    [[nodiscard]] inline int GetResultCount() const { return m_results; }
+
+    /// Gets values yielded or returned by last resume.
+    /// \tparam R Type of result. Tuple to get multiple results.
+    /// \return Result(s). Default constructed if not enough results are available.
+    template <typename R>
+    R GetResult() const {
+        if (m_thread == nullptr || (size_t)m_results < meta::count_expected_v<R>) {
+            return Stack::DefaultReturnWithError<R>("not enough results in coroutine");
+        }
+        return Stack::GetValue<R>(m_thread, -1);
+    }
+
+    /// Resumes coroutine, starting it on first call. Arguments are passed to function on first resume, or returned from yield otherwise.
+    /// Errors are logged with traceback.
+    /// \tparam Args Arguments types.
+    /// \param args Arguments to pass to coroutine.
+    /// \return Status after resuming.
+    template <typename... Args>
+    CoroutineStatus Resume(Args&&... args) {
+        if (IsDone()) {
+            Logger::Error("tried to resume a coroutine not suspended");
+            return m_status;
+        }
+        lua_pop(m_thread, m_results);
+        (Core::Push(m_thread, std::forward<Args>(args)), ...);
+        int status = lua_resume(m_thread, m_state, (int)meta::count_expected_v<Args...>, &m_results);
+        if (status == LUA_YIELD) {
+            m_status = CoroutineStatus::Suspended;
+        } else if (status == LUA_OK) {
+            m_status = CoroutineStatus::Finished;
+        } else {
+            const char* msg = lua_tostring(m_thread, -1);
+            luaL_traceback(m_thread, m_thread, msg != nullptr ? msg : "(error object is not a string)", 0);
+            Logger::Error(lua_tostring(m_thread, -1));
+            lua_settop(m_thread, 0);
+            m_results = 0;
+            m_status = CoroutineStatus::Error;
+        }
+        return m_status;
+    }
+
+private:
+    /// Lua state.
+    lua_State* m_state{nullptr};
+    /// Coroutine thread.
+    lua_State* m_thread{nullptr};
+    /// Number of results of last resume.
+    int m_results{0};
+    /// Current status.
+    CoroutineStatus m_status{CoroutineStatus::Suspended};
+};
+
+/// Drives many coroutines cooperatively. A coroutine that yields a function, from Lua or by returning moon::Yield from a registered C++
+/// function, is only resumed after that function returns true.
+class Scheduler {
+public:
+    explicit Scheduler(lua_State* L) : m_state(L) {}
+
+    /// Starts coroutine, running it until it first yields. Coroutines still suspended are kept to be resumed by Update.
+    /// \tparam Args Arguments types.
+    /// \param coroutine Coroutine to run.
+    /// \param args Arguments to start coroutine with.
+    /// \return Whether or not coroutine was kept, i.e. it yielded.
+    template <typename... Args>
+    bool Spawn(Coroutine&& coroutine, Args&&... args) {
+        Task task{std::move(coroutine), {}};
+        if (!step(task, std::forward<Args>(args)...)) {
+            return false;
+        }
+        m_tasks.emplace_back(std::move(task));
+        return true;
+    }
+
+    /// Resumes once every coroutine that is ready, removing the ones that end.
+    /// \return Number of coroutines still suspended.
+    size_t Update() {
+        for (size_t i = 0; i < m_tasks.size();) {
+            auto& task = m_tasks[i];
+            if (task.ready.IsLoaded() && !task.ready()) {
+                ++i;
+                continue;
+            }
+            if (!step(task)) {
+                task = std::move(m_tasks.back());
+                m_tasks.pop_back();
+                continue;
+            }
+            ++i;
+        }
+        return m_tasks.size();
+    }
+
+    /// Updates until every coroutine ends, yielding calling thread when none is ready.
+    void Run() {
+        while (Update() > 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    /// Getter for number of suspended coroutines.
+    /// \return Number of coroutines.
+    [[nodiscard]] inline size_t GetSize() const { return m_tasks.size(); }
+
+private:
+    /// Suspended coroutine and its readiness check.
+    struct Task {
+        Coroutine coroutine;
+        Function<bool()> ready;
+    };
+
+    /// Resumes task and stores function yielded, if any, as readiness check.
+    /// \return Whether or not coroutine is still suspended.
+    template <typename... Args>
+    bool step(Task& task, Args&&... args) {
+        if (task.coroutine.Resume(std::forward<Args>(args)...) != CoroutineStatus::Suspended) {
+            return false;
+        }
+        lua_State* thread = task.coroutine.GetThread();
+        if (task.coroutine.GetResultCount() > 0 && lua_isfunction(thread, -1)) {
+            lua_pushvalue(thread, -1);
+            lua_xmove(thread, m_state, 1);
+            task.ready = Function<bool()>::CreateAndPop(m_state);
+        } else {
+            task.ready = Function<bool()>{};
+        }
+        return true;
+    }
+
+    /// Lua state.
+    lua_State* m_state{nullptr};
+    /// Suspended coroutines.
+    std::vector<Task> m_tasks;
+};
+}  // namespace moon
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "path.h"
+
+namespace moon {
+template <typename Signature>
+class Function;
+
+/// Handle to a Lua function, resolved once and kept as registry reference. Calls run in protected mode with a traceback message handler.
+/// Arguments and results are marshalled at compile time, and no error message is built unless the call fails.
+/// \tparam Ret Return type. Void, single type or tuple for multiple returns.
+/// \tparam Args Arguments types.
+template <typename Ret, typename... Args>
+class Function<Ret(Args...)> : public Reference {
+public:
+    Function() = default;
+
+    /// Creates a handle of function at index in stack. Logs an error if value is not a function.
+    /// \param L Lua state.
+    /// \param index Index of function in stack.
+    Function(lua_State* L, int index) : m_state(L) {
+        if (!lua_isfunction(L, index)) {
+            Logger::Error("tried to create a Function handle from a value that is not a function");
+            return;
+        }
+        lua_pushvalue(L, index);
+        m_key = luaL_ref(L, LUA_REGISTRYINDEX);
+    }
+
+    Function(const Function&) = delete;
+
+    Function(Function&& other) noexcept : Reference(std::move(other)), m_state(other.m_state) { other.m_state = nullptr; }
+
+    ~Function() {
+        if (m_state == nullptr) {
+            return;
+        }
+        Unload(m_state);
+    }
+
+    Function& operator=(const Function&) = delete;
+
+    Function& operator=(Function&& other) noexcept {
+        if (&other == this) {
+            return *this;
+        }
+        if (m_state != nullptr) {
+            Unload(m_state);
+        }
+        m_key = other.m_key;
+        m_state = other.m_state;
+        other.m_key = LUA_NOREF;
+        other.m_state = nullptr;
+        return *this;
+    }
+
+    /// Will save function at top of stack as reference and pop it.
+    /// \param L Lua state.
+    /// \return Function handle.
+    static Function CreateAndPop(lua_State* L) {
+        Function function{L, -1};
+        lua_pop(L, 1);
+        return function;
+    }
+
+    /// Getter for the Lua state.
+    /// \return Lua state pointer.
+    [[nodiscard]] inline lua_State* GetState() const { return m_state; }
+
+    /// Calls Lua function. Errors are logged with traceback.
+    /// \param args Arguments to pass to function.
+    /// \return Returned value(s) from Lua function. Default constructed on errors.
+    Ret operator()(Args... args) const {
+        if (!IsLoaded()) {
+            return Stack::DefaultReturnWithError<Ret>("tried to call a Function not loaded");
+        }
+        int base = lua_gettop(m_state);
+        lua_pushcfunction(m_state, &Function::traceback);
+        Reference::Push(m_state);
+        (Core::Push(m_state, std::forward<Args>(args)), ...);
+        if (lua_pcall(m_state, (int)meta::count_expected_v<Args...>, results(), base + 1) != LUA_OK) {
+            const char* msg = lua_tostring(m_state, -1);
+            std::string error{msg != nullptr ? msg : "error calling Function"};
+            lua_settop(m_state, base);
+            return Stack::DefaultReturnWithError<Ret>(std::move(error));
+        }
+        if constexpr (std::is_void_v<Ret>) {
+            lua_settop(m_state, base);
+        } else {
+            Ret ret = Stack::GetValue<Ret>(m_state, -1);
+            lua_settop(m_state, base);
+            return ret;
+        }
+    }
+
+private:
+    /// Number of results expected from Lua function.
+    static constexpr int results() {
+        if constexpr (std::is_void_v<Ret>) {
+            return 0;
+        } else {
+            return (int)meta::count_expected_v<Ret>;
+        }
+    }
+
+    /// Message handler, appends traceback to error message.
+    static int traceback(lua_State* L) {
+        const char* msg = lua_tostring(L, 1);
+        luaL_traceback(L, L, msg != nullptr ? msg : "(error object is not a string)", 1);
+        return 1;
+    }
+
+    /// Lua state.
+    lua_State* m_state{nullptr};
+};
+}  // namespace moon
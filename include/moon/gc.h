@@ -0,0 +1,131 @@
+#pragma once
+
+namespace moon {
+constexpr const char* LUA_GC_SENTINEL_META_NAME{"LuaGCSentinel"};
+constexpr const char* LUA_GC_CYCLES_KEY{"MoonGCCycles"};
+
+/// Garbage collector modes.
+enum class GCMode { Incremental, Generational };
+
+/// Controls the garbage collector of a Lua state: mode, tuning parameters, bounded steps and statistics. Completed cycles are counted
+/// with a sentinel object, which is finalized and recreated once per cycle.
+class GarbageCollector {
+public:
+    /// Creates sentinel used to count completed collection cycles.
+    /// \param L Lua state.
+    static void Register(lua_State* L) {
+        lua_pushinteger(L, 0);
+        lua_setfield(L, LUA_REGISTRYINDEX, LUA_GC_CYCLES_KEY);
+
+        luaL_newmetatable(L, LUA_GC_SENTINEL_META_NAME);
+        lua_pushcfunction(L, &GarbageCollector::sentinel);
+        lua_setfield(L, -2, "__gc");
+        lua_pop(L, 1);
+
+        pushSentinel(L);
+    }
+
+    explicit GarbageCollector(lua_State* L) : m_state(L) {}
+
+    /// Getter for the Lua state.
+    /// \return Lua state pointer.
+    [[nodiscard]] inline lua_State* GetState() const { return m_state; }
+
+    /// Switches to incremental mode.
+    /// \param pause How long collector waits before starting a new cycle, in percentage of memory in use after last one. 0 keeps current.
+    /// \param stepMultiplier Speed of collector relative to memory allocation, in percentage. 0 keeps current.
+    /// \param stepSize Log2 of bytes allocated between steps. 0 keeps current.
+    /// \return Previous mode.
+    GCMode SetIncremental(int pause = 0, int stepMultiplier = 0, int stepSize = 0) const {
+        return toMode(lua_gc(m_state, LUA_GCINC, pause, stepMultiplier, stepSize));
+    }
+
+    /// Switches to generational mode.
+    /// \param minorMultiplier Frequency of minor collections, in percentage of memory growth. 0 keeps current.
+    /// \param majorMultiplier Memory growth, in percentage, that triggers a major collection. 0 keeps current.
+    /// \return Previous mode.
+    GCMode SetGenerational(int minorMultiplier = 0, int majorMultiplier = 0) const {
+        return toMode(lua_gc(m_state, LUA_GCGEN, minorMultiplier, majorMultiplier));
+    }
+
+    /// Setter for pause of incremental mode, without switching mode.
+    /// \param pause Pause in percentage.
+    /// \return Previous pause.
+    int SetPause(int pause) const { return lua_gc(m_state, LUA_GCSETPAUSE, pause); }
+
+    /// Setter for step multiplier of incremental mode, without switching mode.
+    /// \param stepMultiplier Step multiplier in percentage.
+    /// \return Previous step multiplier.
+    int SetStepMultiplier(int stepMultiplier) const { return lua_gc(m_state, LUA_GCSETSTEPMUL, stepMultiplier); }
+
+    /// Performs an incremental step of collection.
+    /// \param budget Work to perform, as if this number of KBytes were allocated. 0 performs a single basic step.
+    /// \return Whether or not step finished a cycle.
+    bool Step(int budget = 0) const { return lua_gc(m_state, LUA_GCSTEP, budget) != 0; }
+
+    /// Performs basic steps of collection until time budget is spent or a cycle finishes, e.g. on idle time between frames.
+    /// \param budget Time budget.
+    /// \return Whether or not a cycle was finished.
+    bool StepFor(std::chrono::microseconds budget) const {
+        auto deadline = std::chrono::steady_clock::now() + budget;
+        do {
+            if (Step()) {
+                return true;
+            }
+        } while (std::chrono::steady_clock::now() < deadline);
+        return false;
+    }
+
+    /// Performs a full collection cycle.
+    void Collect() const { lua_gc(m_state, LUA_GCCOLLECT); }
+
+    /// Stops automatic collection. Steps and full collections still work.
+    void Stop() const { lua_gc(m_state, LUA_GCSTOP); }
+
+    /// Restarts automatic collection.
+    void Restart() const { lua_gc(m_state, LUA_GCRESTART); }
+
+    /// Checks if automatic collection is running.
+    /// \return Whether or not collector is running.
+    [[nodiscard]] bool IsRunning() const { return lua_gc(m_state, LUA_GCISRUNNING) != 0; }
+
+    /// Getter for memory in use by Lua.
+    /// \return Heap size in bytes.
+    [[nodiscard]] size_t GetHeapSize() const {
+        return (size_t)lua_gc(m_state, LUA_GCCOUNT) * 1024 + (size_t)lua_gc(m_state, LUA_GCCOUNTB);
+    }
+
+    /// Getter for number of collection cycles completed since state creation.
+    /// \return Number of cycles.
+    [[nodiscard]] size_t GetCycles() const {
+        lua_getfield(m_state, LUA_REGISTRYINDEX, LUA_GC_CYCLES_KEY);
+        auto cycles = (size_t)lua_tointeger(m_state, -1);
+        lua_pop(m_state, 1);
+        return cycles;
+    }
+
+private:
+    static GCMode toMode(int mode) { return mode == LUA_GCGEN ? GCMode::Generational : GCMode::Incremental; }
+
+    /// Pushes and immediately drops a new sentinel, collectable in next cycle.
+    static void pushSentinel(lua_State* L) {
+        lua_newuserdata(L, 1);
+        luaL_setmetatable(L, LUA_GC_SENTINEL_META_NAME);
+        lua_pop(L, 1);
+    }
+
+    /// Sentinel finalizer, counts cycle and creates next sentinel.
+    static int sentinel(lua_State* L) {
+        lua_getfield(L, LUA_REGISTRYINDEX, LUA_GC_CYCLES_KEY);
+        lua_Integer cycles = lua_tointeger(L, -1) + 1;
+        lua_pop(L, 1);
+        lua_pushinteger(L, cycles);
+        lua_setfield(L, LUA_REGISTRYINDEX, LUA_GC_CYCLES_KEY);
+        pushSentinel(L);
+        return 0;
+    }
+
+    /// Lua state.
+    lua_State* m_state{nullptr};
+};
+}  // namespace moon
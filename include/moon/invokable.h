@@ -1,24 +1,28 @@
 #pragma once
 
-#include "stack.h"
+#include "usertype.h"
 
 namespace moon {
 constexpr const char* LUA_INVOKABLE_HOLDER_META_NAME{"LuaInvokableHolder"};
 
+/// Returned by registered C++ functions to yield the running coroutine. When set, ready is yielded to Lua as a function and the
+/// scheduler only resumes the coroutine after it returns true, e.g. once a future is ready.
+struct Yield {
+    /// Optional readiness check.
+    std::function<bool()> ready{};
+};
+
+/// Exposes C++ callables to Lua as C closures. Argument unpacking and return pushing are generated at compile time per callable type.
+/// Callables are stored in-place, in a userdata kept as closure upvalue. Only non trivially destructible callables get a metatable,
+/// which is needed to call their destructor when collected.
 class Invokable {
 public:
-    virtual ~Invokable() = default;
-
-    virtual int Call(lua_State*) const = 0;
-
+    /// Registers the metatable used for callables that need to be destroyed when collected.
+    /// \param L Lua state.
     static void Register(lua_State* L) {
         luaL_newmetatable(L, LUA_INVOKABLE_HOLDER_META_NAME);
         int metatable = lua_gettop(L);
 
-        lua_pushstring(L, "__call");
-        lua_pushcfunction(L, &Invokable::call);
-        lua_settable(L, metatable);
-
         lua_pushstring(L, "__gc");
         lua_pushcfunction(L, &Invokable::gc);
         lua_settable(L, metatable);
@@ -30,41 +34,134 @@ public:
         lua_pop(L, 1);
     }
 
+    /// Pushes a C closure that calls provided callable. Callable is moved/copied into closure upvalue.
+    /// \tparam Func Callable type. Function pointers or non generic functors.
+    /// \param L Lua state.
+    /// \param func Callable to push.
+    template <typename Func>
+    static void Push(lua_State* L, Func&& func) {
+        using func_t = std::decay_t<Func>;
+        using holder_t = Holder<func_t>;
+        static_assert(alignof(holder_t) <= alignof(std::max_align_t), "over aligned callables are not supported");
+        void* storage = lua_newuserdata(L, sizeof(holder_t));
+        new (storage) holder_t{&holder_t::destroy, std::forward<Func>(func)};
+        if constexpr (!std::is_trivially_destructible_v<func_t>) {
+            luaL_getmetatable(L, LUA_INVOKABLE_HOLDER_META_NAME);
+            lua_setmetatable(L, -2);
+        }
+        pushStats(L);
+        lua_pushcclosure(L, &Invokable::call<func_t>, 1 + s_statsUpvalues);
+    }
+
+    /// Pushes a plain C function, with no upvalues, that calls provided compile time function.
+    /// \tparam func Function pointer to call.
+    /// \param L Lua state.
+    template <auto func>
+    static void Push(lua_State* L) {
+        pushStats(L);
+        lua_pushcclosure(L, &Invokable::callStatic<func>, s_statsUpvalues);
+    }
+
+    /// Names call site of closure at index, so its calls are recorded apart. Does nothing unless instrumentation is enabled.
+    /// \tparam Name Name type. String or number.
+    /// \param L Lua state.
+    /// \param index Index of closure in stack, pushed by Invokable.
+    /// \param name Call site name, usually name closure is registered with.
+    template <typename Name>
+    static void SetName(lua_State* L, int index, Name&& name) {
+        if constexpr (Profiler::s_enabled) {
+            index = lua_absindex(L, index);
+            lua_Debug ar;
+            lua_pushvalue(L, index);
+            lua_getinfo(L, ">u", &ar);
+            lua_pushlightuserdata(L, &Profiler::Get(ProfileCategory::Function, std::forward<Name>(name)));
+            lua_setupvalue(L, index, ar.nups);  // Statistics are always last upvalue
+        }
+    }
+
 private:
+    /// Number of upvalues holding call site statistics, the last ones of every closure.
+    static constexpr int s_statsUpvalues{Profiler::s_enabled ? 1 : 0};
+
+    /// Pushes statistics of unnamed call sites, when instrumentation is enabled.
+    static inline void pushStats(lua_State* L) {
+        if constexpr (Profiler::s_enabled) {
+            lua_pushlightuserdata(L, &Profiler::Get(ProfileCategory::Function, "(anonymous)"));
+        }
+    }
+
+    /// Userdata layout. Destroy function must come first, since it is read in a type erased manner by gc.
+    /// \tparam Func Callable type.
+    template <typename Func>
+    struct Holder {
+        /// Type erased destroy function.
+        void (*destructor)(void*);
+        /// Stored callable.
+        Func func;
+
+        static void destroy(void* storage) { static_cast<Holder*>(storage)->~Holder(); }
+    };
+
+    template <typename Func>
     static int call(lua_State* L) {
-        void* storage = lua_touserdata(L, 1);
-        auto* invokable = *static_cast<Invokable**>(storage);
-        lua_remove(L, 1);
-        return invokable->Call(L);
+        auto* holder = static_cast<Holder<Func>*>(lua_touserdata(L, lua_upvalueindex(1)));
+        auto sample = Profiler::Begin(L);
+        int results = invoke(holder->func, L);
+        Profiler::End(L, lua_upvalueindex(2), sample);
+        return complete<Func>(L, results);
     }
 
-    static int gc(lua_State* L) {
-        void* storage = lua_touserdata(L, 1);
-        auto* invokable = *static_cast<Invokable**>(storage);
-        delete invokable;
-        return 0;
+    template <auto func>
+    static int callStatic(lua_State* L) {
+        auto sample = Profiler::Begin(L);
+        int results = invoke(func, L);
+        Profiler::End(L, lua_upvalueindex(1), sample);
+        return complete<decltype(func)>(L, results);
     }
-};
 
-template <typename Ret, typename... Args>
-class InvokableSTLFunction : public Invokable {
-public:
-    explicit InvokableSTLFunction(std::function<Ret(Args...)> func_) : func(std::move(func_)) {}
+    /// Returns results pushed by callable, yielding them instead if callable returned moon::Yield.
+    template <typename Func>
+    static inline int complete(lua_State* L, int results) {
+        if constexpr (std::is_same_v<std::decay_t<typename meta::function_traits<Func>::return_type>, Yield>) {
+            // Yielding jumps out of this function, so no C++ object can be alive when it happens
+            return lua_yield(L, results);
+        } else {
+            return results;
+        }
+    }
 
-    inline int Call(lua_State* L) const final { return callHelper(std::make_index_sequence<sizeof...(Args)>{}, func, L); }
+    template <typename Func>
+    static inline int invoke(Func&& func, lua_State* L) {
+        using traits = meta::function_traits<Func>;
+        return invokeHelper<typename traits::return_type>(std::make_index_sequence<std::tuple_size_v<typename traits::arguments>>{}, func,
+                                                          L, static_cast<typename traits::arguments*>(nullptr));
+    }
 
-private:
-    std::function<Ret(Args...)> func;
+    template <typename Ret, size_t... indices, typename Func, typename... Args>
+    static inline int invokeHelper(std::index_sequence<indices...>, Func&& func, lua_State* L, std::tuple<Args...>*) {
+        if constexpr (std::is_void_v<Ret>) {
+            func(std::forward<std::decay_t<Args>>(Stack::GetValue<std::decay_t<Args>>(L, indices + 1))...);
+            return 0;
+        } else if constexpr (std::is_same_v<std::decay_t<Ret>, Yield>) {
+            return pushYield(L, func(std::forward<std::decay_t<Args>>(Stack::GetValue<std::decay_t<Args>>(L, indices + 1))...));
+        } else {
+            Stack::PushValue(L, func(std::forward<std::decay_t<Args>>(Stack::GetValue<std::decay_t<Args>>(L, indices + 1))...));
+            return meta::count_expected_v<Ret>;
+        }
+    }
 
-    template <size_t... indices, typename RetHelper>
-    static int callHelper(std::index_sequence<indices...>, const std::function<RetHelper(Args...)>& func, lua_State* L) {
-        Stack::PushValue(L, func(std::forward<std::decay_t<Args>>(Stack::GetValue<std::decay_t<Args>>(L, indices + 1))...));
-        return meta::count_expected_v<RetHelper>;
+    static int pushYield(lua_State* L, Yield&& yield) {
+        if (!yield.ready) {
+            return 0;
+        }
+        Push(L, std::move(yield.ready));
+        return 1;
     }
 
-    template <size_t... indices>
-    static int callHelper(std::index_sequence<indices...>, const std::function<void(Args...)>& func, lua_State* L) {
-        func(std::forward<std::decay_t<Args>>(Stack::GetValue<std::decay_t<Args>>(L, indices + 1))...);
+    static int gc(lua_State* L) {
+        void* storage = lua_touserdata(L, 1);
+        auto destructor = *static_cast<void (**)(void*)>(storage);
+        destructor(storage);
         return 0;
     }
 };
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "reference.h"
+
+namespace moon {
+/// String key interned once, as a Lua string referenced in registry. Usable wherever a global or field name is, e.g. Moon::Get<int>(key),
+/// so hot accesses push the cached string, whose hash Lua already knows, instead of hashing a C string again. Accesses through interned
+/// keys are raw, bypassing __index and __newindex metamethods. Only valid in state it was created in and its threads.
+class InternedKey : public Reference {
+public:
+    InternedKey() = default;
+
+    /// Interns name in state.
+    /// \param L Lua state.
+    /// \param name Key name.
+    InternedKey(lua_State* L, std::string_view name) : m_state(L), m_name(name) {
+        lua_pushlstring(L, name.data(), name.size());
+        m_key = luaL_ref(L, LUA_REGISTRYINDEX);
+    }
+
+    InternedKey(const InternedKey&) = delete;
+
+    InternedKey(InternedKey&& other) noexcept : Reference(std::move(other)), m_state(other.m_state), m_name(std::move(other.m_name)) {
+        other.m_state = nullptr;
+    }
+
+    ~InternedKey() {
+        if (m_state == nullptr) {
+            return;
+        }
+        Unload(m_state);
+    }
+
+    InternedKey& operator=(const InternedKey&) = delete;
+
+    InternedKey& operator=(InternedKey&& other) noexcept {
+        if (&other == this) {
+            return *this;
+        }
+        if (m_state != nullptr) {
+            Unload(m_state);
+        }
+        m_key = other.m_key;
+        m_state = other.m_state;
+        m_name = std::move(other.m_name);
+        other.m_key = LUA_NOREF;
+        other.m_state = nullptr;
+        return *this;
+    }
+
+    /// Getter for the Lua state.
+    /// \return Lua state pointer.
+    [[nodiscard]] inline lua_State* GetState() const { return m_state; }
+
+    /// Getter for key name.
+    /// \return Name.
+    [[nodiscard]] inline std::string_view GetName() const { return m_name; }
+
+    explicit operator std::string_view() const { return m_name; }
+
+private:
+    /// Lua state.
+    lua_State* m_state{nullptr};
+    /// Key name, kept for diagnostics.
+    std::string m_name;
+};
+}  // namespace moon
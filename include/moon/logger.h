@@ -27,7 +27,11 @@ private:
     /// Logs a new message to callback.
     /// \param level Level of log.
     /// \param message Message to log.
-    static void log(Level level, const std::string& message) { s_callback(level, std::string("Moon :: ").append(message)); }
+    static void log(Level level, const std::string& message) {
+        if (s_callback) {
+            s_callback(level, std::string("Moon :: ").append(message));
+        }
+    }
 
     /// Called when a log occurs, receiving log severity and message.
     static inline std::function<void(Level, const std::string&)> s_callback{};
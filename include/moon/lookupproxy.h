@@ -20,6 +20,16 @@ public:
         return get<R>(std::make_index_sequence<std::tuple_size_v<proxy_key_t>>{});
     }
 
+    template <typename R>
+    inline Expected<std::decay_t<R>> TryGet() const {
+        return tryGet<R>(std::make_index_sequence<std::tuple_size_v<proxy_key_t>>{});
+    }
+
+    template <typename... Rets, typename... Keys>
+    inline decltype(auto) GetFields(Keys&&... keys) const {
+        return getFields<Rets...>(std::make_index_sequence<std::tuple_size_v<proxy_key_t>>{}, std::forward<Keys>(keys)...);
+    }
+
     template <typename T>
     inline void Set(T&& value) const {
         set(std::make_index_sequence<std::tuple_size_v<proxy_key_t>>{}, std::forward<T>(value));
@@ -67,6 +77,22 @@ private:
         return Core::GetNested<Ret, Lookup::global>(m_table->GetState(), std::get<indices>(m_key)...);
     }
 
+    template <typename Ret, size_t... indices>
+    decltype(auto) tryGet(std::index_sequence<indices...>) const {
+        Stack::PopGuard guard{m_table->GetState(), m_table->Push()};
+        return Core::TryGet<Ret, Lookup::global>(m_table->GetState(), std::get<indices>(m_key)...);
+    }
+
+    template <typename... Rets, size_t... indices, typename... Keys>
+    decltype(auto) getFields(std::index_sequence<indices...>, Keys&&... keys) const {
+        lua_State* L = m_table->GetState();
+        int top = lua_gettop(L);
+        static_cast<void>(m_table->Push());
+        Core::PushField<Lookup::global>(L, std::get<indices>(m_key)...);
+        Stack::PopGuard guard{L, lua_gettop(L) - top};  // Lookup table, if any, and table holding fields
+        return Core::GetFields<Rets...>(L, -1, std::forward<Keys>(keys)...);
+    }
+
     template <size_t... indices, typename T>
     decltype(auto) set(std::index_sequence<indices...>, T&& value) const {
         Stack::PopGuard guard{m_table->GetState(), m_table->Push()};
@@ -3,30 +3,48 @@
 #ifndef MOON_H
 #define MOON_H
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <functional>
+#include <iterator>
+#include <limits>
 #include <lua.hpp>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <sys/stat.h>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
-#include "object.h"
-#include "stateview.h"
+#include "parallel.h"
+#include "state.h"
+#include "statepool.h"
 
 #define MOON_DECLARE_CLASS(_class) static moon::Binding<_class> Binding;
 
-#define MOON_PROPERTY(_property)                       \
-    int Get_##_property(lua_State* L) {                \
-        Moon::Push(_property);                         \
-        return 1;                                      \
-    }                                                  \
-    int Set_##_property(lua_State* L) {                \
-        _property = Moon::Get<decltype(_property)>(1); \
-        return 0;                                      \
+#define MOON_PROPERTY(_property)                                \
+    int Get_##_property(lua_State* L) {                         \
+        moon::Core::Push(L, _property);                         \
+        return 1;                                               \
+    }                                                           \
+    int Set_##_property(lua_State* L) {                         \
+        _property = moon::Core::Get<decltype(_property)>(L, 1); \
+        return 0;                                               \
     }
 
 #define MOON_METHOD(_name) int _name(lua_State* L)
@@ -35,96 +53,161 @@
     using BindingType = _class;     \
     moon::Binding<BindingType> BindingType::Binding = moon::Binding<BindingType>(#_class)
 
+#define MOON_DEFINE_BINDING_TABLE(_class, ...)                                                        \
+    using BindingType = _class;                                                                       \
+    moon::Binding<BindingType> BindingType::Binding = moon::Binding<BindingType>(#_class, []() -> const auto& { \
+        static constexpr auto table = moon::MakeBindingTable<BindingType>(__VA_ARGS__);              \
+        return table;                                                                                 \
+    }())
+
+#define MOON_TABLE_METHOD(_method) moon::LuaClass<BindingType>::MakeMethod<&BindingType::_method>(#_method)
+
+#define MOON_TABLE_PROPERTY(_prop) moon::LuaClass<BindingType>::PropertyType{#_prop, &BindingType::Get_##_prop, &BindingType::Set_##_prop}
+
+#define MOON_TABLE_MEMBER(_member) moon::LuaClass<BindingType>::MakeProperty<&BindingType::_member>(#_member)
+
 #define MOON_REMOVE_GC .RemoveGC()
 
-#define MOON_ADD_METHOD(_method) .AddMethod({#_method, &BindingType::_method})
+#define MOON_LAZY_REGISTRATION .LazyRegistration()
+
+#define MOON_INLINE_STORAGE .InlineStorage()
+
+#define MOON_ADD_METHOD(_method) .AddMethod(#_method, &BindingType::_method)
 
 #define MOON_ADD_PROPERTY(_prop) .AddProperty({#_prop, &BindingType::Get_##_prop, &BindingType::Set_##_prop})
 
+#define MOON_ADD_MEMBER(_member) .AddProperty(#_member, &BindingType::_member)
+
 #define MOON_ADD_PROPERTY_CUSTOM(_prop, _getter, _setter) .AddProperty({#_prop, &BindingType::_getter, &BindingType::_setter})
 
 /// Handles all the logic related to "communication" between C++ and Lua, initializing it.
 /// Acts as an engine to allow to call C++ functions from Lua and vice-versa, registers
 /// and exposes C++ classes to Lua, pops and pushes values to Lua stack, runs file scripts and
 /// string scripts, allows easy access to nested properties in Lua objects, as well as global ones.
+/// Static facade over a default moon::State instance. For multiple independent states, use moon::State directly.
 class Moon {
 public:
     /// Initializes Lua state, opens libs and initializes helper classes.
     static void Init() {
-        s_state = luaL_newstate();
-        luaL_openlibs(s_state);
+        s_state.emplace();
         moon::Logger::SetCallback([](moon::Logger::Level, const std::string&) {});
-        moon::Invokable::Register(s_state);
-        moon::StateView::Instance().initialize(s_state);
     }
 
-    /// Closes Lua state.
-    static inline void CloseState() {
-        lua_close(s_state);
-        s_state = nullptr;
+    /// Initializes Lua state with custom allocator, opens libs and initializes helper classes.
+    /// \param allocator Allocator owned by state.
+    static void Init(std::unique_ptr<moon::Allocator> allocator) {
+        s_state.emplace(std::move(allocator));
+        moon::Logger::SetCallback([](moon::Logger::Level, const std::string&) {});
+    }
+
+    /// Initializes Lua state opening only selected standard libraries, e.g. moon::Sandbox::Safe for untrusted scripts.
+    /// \param allocator Allocator owned by state. Default Lua allocator is used if null.
+    /// \param libraries Flags of libraries to open, from moon::Sandbox::Libraries.
+    static void Init(std::unique_ptr<moon::Allocator> allocator, unsigned libraries) {
+        s_state.emplace(std::move(allocator), libraries);
+        moon::Logger::SetCallback([](moon::Logger::Level, const std::string&) {});
     }
 
+    /// Getter for garbage collector controls of default state.
+    /// \return Garbage collector.
+    static inline moon::GarbageCollector GC() { return s_state->GC(); }
+
+    /// Encodes value at index in stack as binary, appending it to buffer. See moon::Serializer.
+    /// \param index Index of value in stack.
+    /// \param buffer Buffer to append to.
+    /// \return Whether or not value was encoded.
+    static inline bool Encode(int index, std::vector<uint8_t>& buffer) { return s_state->Encode(index, buffer); }
+
+    /// Decodes a value encoded as binary.
+    /// \param buffer Encoded data.
+    /// \return Object referencing decoded value, not loaded on errors.
+    static inline moon::Object Decode(const std::vector<uint8_t>& buffer) { return s_state->Decode(buffer); }
+
+    /// Closes Lua state.
+    static inline void CloseState() { s_state.reset(); }
+
     /// Set a logger callback.
     /// \param logger Callback which is gonna be called every time a log occurs.
     static inline void SetLogger(std::function<void(moon::Logger::Level, const std::string&)> logger) {
         moon::Logger::SetCallback(std::move(logger));
     }
 
+    /// Getter for default state instance.
+    /// \return Moon state.
+    static inline moon::State& GetDefault() { return *s_state; }
+
     /// Getter for Lua state/stack.
     /// \return Lua state pointer.
-    static inline lua_State* GetState() { return s_state; }
+    static inline lua_State* GetState() { return s_state.has_value() ? s_state->GetState() : nullptr; }
 
     /// Getter for top index in Lua stack.
     /// \return Lua stack top index.
-    static inline int GetTop() { return lua_gettop(s_state); }
+    static inline int GetTop() { return s_state->GetTop(); }
 
     /// Checks if provided index is valid within the range of current Lua stack.
     /// \param index Index to check.
     /// \return Whether or not index is valid.
-    static bool IsValidIndex(int index) {
-        int top = GetTop();
-        if (index == 0 || index > top) {
-            return false;
-        }
-        if (index < 0) {
-            return IsValidIndex(top + index + 1);
-        }
-        return true;
-    }
+    static inline bool IsValidIndex(int index) { return s_state->IsValidIndex(index); }
 
     /// Lua stack can be accessed with positive (up de stack) or negative (down the stack) indexes.
     /// This method converts a negative index to a positive one. Returns original if already positive.
     /// \param index Index to convert.
     /// \return Newly converted index.
-    static inline int ConvertNegativeIndex(int index) { return lua_absindex(s_state, index); }
+    static inline int ConvertNegativeIndex(int index) { return s_state->ConvertNegativeIndex(index); }
 
     /// Loads specified file script.
     /// \param filePath File path to load.
     /// \return Whether or not file was successfully loaded.
-    static bool LoadFile(const char* filePath) {
-        if (!checkStatus(luaL_loadfile(s_state, filePath), "Error loading file")) {
-            return false;
-        }
-        return checkStatus(lua_pcall(s_state, 0, LUA_MULTRET, 0), "Loading file failed");
-    }
+    static inline bool LoadFile(const char* filePath) { return s_state->LoadFile(filePath); }
 
     /// Runs Lua code snippet.
     /// \param code Code to run.
     /// \return Whether or not code ran without errors.
-    static bool RunCode(const char* code) {
-        if (!checkStatus(luaL_loadstring(s_state, code), "Error running code")) {
-            return false;
-        }
-        return checkStatus(lua_pcall(s_state, 0, LUA_MULTRET, 0), "Running code failed");
+    static inline bool RunCode(const char* code) { return s_state->RunCode(code); }
+
+    /// Runs Lua code snippet with bounded instructions, time and memory.
+    /// \param code Code to run.
+    /// \param limits Resource limits.
+    /// \return Outcome of code.
+    static inline moon::SandboxStatus RunSandboxed(const char* code, const moon::SandboxLimits& limits) {
+        return s_state->RunSandboxed(code, limits);
     }
 
+    /// Loads specified text file script with bounded instructions, time and memory.
+    /// \param filePath File path to load.
+    /// \param limits Resource limits.
+    /// \return Outcome of file.
+    static inline moon::SandboxStatus LoadSandboxedFile(const char* filePath, const moon::SandboxLimits& limits) {
+        return s_state->LoadSandboxedFile(filePath, limits);
+    }
+
+    /// Compiles Lua code snippet without running it. Returned chunk can be ran multiple times without parsing code again.
+    /// \param code Code to compile.
+    /// \return Compiled chunk. Not loaded on errors.
+    static inline moon::Chunk CompileCode(const char* code) { return s_state->CompileCode(code); }
+
+    /// Compiles file script, source or precompiled, without running it.
+    /// \param filePath File path to compile.
+    /// \return Compiled chunk. Not loaded on errors.
+    static inline moon::Chunk CompileFile(const char* filePath) { return s_state->CompileFile(filePath); }
+
+    /// Runs Lua code snippet, compiling it only the first time it is seen.
+    /// \param code Code to run.
+    /// \return Whether or not code ran without errors.
+    static inline bool RunCachedCode(const char* code) { return s_state->RunCachedCode(code); }
+
+    /// Loads specified file script, compiling it only if not cached or if file was modified since.
+    /// \param filePath File path to load.
+    /// \return Whether or not file was successfully loaded.
+    static inline bool LoadCachedFile(const char* filePath) { return s_state->LoadCachedFile(filePath); }
+
     /// Get type of Lua value at index in stack or with specific name.
     /// \tparam Keys Type of key(s) (integer/string).
     /// \param keys Key(s) to check type of. When multiple are provided, nested global search will be used.
     /// \return Moon type of value.
     template <typename... Keys>
     static inline moon::LuaType GetType(Keys&&... keys) {
-        return moon::Core::GetType(s_state, std::forward<Keys>(keys)...);
+        return s_state->GetType(std::forward<Keys>(keys)...);
     }
 
     /// Checks if Lua value in index/name can be interpreted as specified C type.
@@ -134,7 +217,7 @@ public:
     /// \return Whether or not value can be interpreted at specific type.
     template <typename T, typename... Keys>
     static inline bool Check(Keys&&... keys) {
-        return moon::Core::Check<T>(s_state, std::forward<Keys>(keys)...);
+        return s_state->Check<T>(std::forward<Keys>(keys)...);
     }
 
     /// Cleans/nulls a variable, nested or not.
@@ -142,7 +225,7 @@ public:
     /// \param keys Nested (or not) keys path to arrive at variable to clean.
     template <typename... Keys>
     static inline void Clean(Keys&&... keys) {
-        moon::Core::Clean(s_state, std::forward<Keys>(keys)...);
+        s_state->Clean(std::forward<Keys>(keys)...);
     }
 
     /// Gets element(s) at specified Lua stack index and/or global name as C object.
@@ -152,7 +235,7 @@ public:
     /// \return C object.
     template <typename... Rets, typename... Keys>
     static inline decltype(auto) Get(Keys&&... keys) {
-        return moon::Core::Get<Rets...>(s_state, std::forward<Keys>(keys)...);
+        return s_state->Get<Rets...>(std::forward<Keys>(keys)...);
     }
 
     /// Gets a single nested (or global, if single key is provided) value from Lua global table.
@@ -162,7 +245,18 @@ public:
     /// \return C object.
     template <typename Ret, typename... Keys>
     static inline decltype(auto) GetNested(Keys&&... keys) {
-        return moon::Core::GetNested<Ret>(s_state, std::forward<Keys>(keys)...);
+        return s_state->GetNested<Ret>(std::forward<Keys>(keys)...);
+    }
+
+    /// Gets a single nested (or global, if single key is provided) value, checking and converting it at once. Failures are not logged,
+    /// so this is suited for hot loops and for values that may legitimately be missing.
+    /// \tparam Ret C type to cast Lua object to.
+    /// \tparam Keys Integral or string.
+    /// \param keys Path to arrive at variable.
+    /// \return Value or reason it could not be read.
+    template <typename Ret, typename... Keys>
+    static inline moon::Expected<std::decay_t<Ret>> TryGet(Keys&&... keys) {
+        return s_state->TryGet<Ret>(std::forward<Keys>(keys)...);
     }
 
     /// Sets one or multiple pairs name/value globals in Lua.
@@ -171,7 +265,7 @@ public:
     /// \example Set("first", 1, "second", true,...)
     template <typename... Pairs>
     static inline void Set(Pairs&&... pairs) {
-        moon::Core::Set(s_state, std::forward<Pairs>(pairs)...);
+        s_state->Set(std::forward<Pairs>(pairs)...);
     }
 
     /// Sets a nested (or global) variable value. New keys are also created in table.
@@ -182,7 +276,7 @@ public:
     /// Moon::SetNested("map", "y", "z", 6)
     template <typename... Args>
     static inline void SetNested(Args&&... args) {
-        moon::Core::SetNested(s_state, std::forward<Args>(args)...);
+        s_state->SetNested(std::forward<Args>(args)...);
     }
 
     /// Recursive helper method to push multiple values directly to Lua stack.
@@ -190,7 +284,7 @@ public:
     /// \param args Values to push to Lua stack.
     template <typename... Args>
     static inline void Push(Args&&... args) {
-        (moon::Core::Push(s_state, std::forward<Args>(args)), ...);
+        s_state->Push(std::forward<Args>(args)...);
     }
 
     /// Get, assign or call a global variable from Lua. Assignment operator, callable and implicit conversion are enabled for ease of use.
@@ -199,7 +293,7 @@ public:
     /// \return Lookup proxy with assignment, call and implicit cast enabled.
     template <typename Key>
     static inline moon::LookupProxy<moon::StateView, Key> At(Key&& key) {
-        return {&moon::StateView::Instance(), std::forward<Key>(key)};
+        return s_state->At(std::forward<Key>(key));
     }
 
     /// Access/create global scope and nested variables/functions in tables, directly with stl style operators, like [] and ().
@@ -210,33 +304,24 @@ public:
     /// view["f"](true);<br>
     /// view["map"]["x"][1] = 2;
     /// \return
-    static inline moon::StateView& View() { return moon::StateView::Instance(); }
+    static inline moon::StateView& View() { return s_state->View(); }
 
     /// Push a nil (null) value to Lua stack.
-    static inline void PushNull() { lua_pushnil(s_state); }
+    static inline void PushNull() { s_state->PushNull(); }
 
     /// Pushes a new empty table/map to stack.
-    static inline void PushTable() { lua_newtable(s_state); }
+    static inline void PushTable() { s_state->PushTable(); }
 
     /// Tries to pop specified number of elements from stack. Logs an error if top is reached not popping any more.
     /// \param nrOfElements Number of elements to pop from Lua stack.
-    static void Pop(int nrOfElements = 1) {
-        while (nrOfElements > 0) {
-            if (GetTop() <= 0) {
-                moon::Logger::Warning("tried to pop stack but was empty already");
-                break;
-            }
-            lua_pop(s_state, 1);
-            --nrOfElements;
-        }
-    }
+    static inline void Pop(int nrOfElements = 1) { s_state->Pop(nrOfElements); }
 
     /// Registers and exposes C++ class to Lua.
     /// \tparam T Class to be registered.
     /// \param nameSpace Class namespace.
     template <class T>
     static inline void RegisterClass(const char* nameSpace = nullptr) {
-        moon::LuaClass<T>::Register(s_state, nameSpace);
+        s_state->RegisterClass<T>(nameSpace);
     }
 
     /// Registers and exposes C++ function to Lua.
@@ -246,8 +331,16 @@ public:
     /// \param func Function to register.
     template <typename Name, typename Func>
     static inline void RegisterFunction(Name&& name, Func&& func) {
-        moon::Core::PushFunction(s_state, std::forward<Func>(func));
-        moon::Core::FieldHandler<true, Name>{}.Set(s_state, -1, std::forward<Name>(name));
+        s_state->RegisterFunction(std::forward<Name>(name), std::forward<Func>(func));
+    }
+
+    /// Registers and exposes a compile time known C++ function to Lua, as a plain C function without upvalues.
+    /// \tparam func Function pointer to register.
+    /// \tparam Name Name type forwarding.
+    /// \param name Function name to register in Lua.
+    template <auto func, typename Name>
+    static inline void RegisterFunction(Name&& name) {
+        s_state->RegisterFunction<func>(std::forward<Name>(name));
     }
 
     /// Calls a global Lua function.
@@ -259,8 +352,7 @@ public:
     /// \return Return value of function.
     template <typename... Ret, typename Key, typename... Args>
     static inline decltype(auto) Call(Key&& key, Args&&... args) {
-        moon::Core::FieldHandler<true, Key>{}.Get(s_state, 0, std::forward<Key>(key));
-        return moon::Core::Call<Ret...>(s_state, std::forward<Args>(args)...);
+        return s_state->Call<Ret...>(std::forward<Key>(key), std::forward<Args>(args)...);
     }
 
     /// Make moon object directly in Lua stack from C object. Stack is immediately popped, since the reference is stored.
@@ -269,98 +361,62 @@ public:
     /// \return Newly created moon object.
     template <typename T>
     static inline moon::Object MakeObject(T&& value) {
-        moon::Core::Push(s_state, std::forward<T>(value));
-        return moon::Object::CreateAndPop(s_state);
+        return s_state->MakeObject(std::forward<T>(value));
     }
 
     /// Creates and stores a new ref of element at provided index.
     /// \param index Index of element to create ref. Defaults to top of stack.
     /// \return A new moon Object.
-    static inline moon::Object MakeObjectFromIndex(int index = -1) { return {s_state, index}; }
+    static inline moon::Object MakeObjectFromIndex(int index = -1) { return s_state->MakeObjectFromIndex(index); }
+
+    /// Creates a handle to a global Lua function, resolved once, for fast repeated calls.
+    /// \tparam Signature Function signature, e.g. `int(int, int)`.
+    /// \tparam Keys Key types (integer/string).
+    /// \param keys Key(s) of function. When multiple are provided, nested global search will be used.
+    /// \return A new moon Function. Not loaded if value is not a function.
+    template <typename Signature, typename... Keys>
+    static inline moon::Function<Signature> MakeFunction(Keys&&... keys) {
+        return s_state->MakeFunction<Signature>(std::forward<Keys>(keys)...);
+    }
+
+    /// Creates a coroutine running a global Lua function.
+    /// \tparam Keys Key types (integer/string).
+    /// \param keys Key(s) of function. When multiple are provided, nested global search will be used.
+    /// \return A new moon Coroutine. Not loaded if value is not a function.
+    template <typename... Keys>
+    static inline moon::Coroutine MakeCoroutine(Keys&&... keys) {
+        return s_state->MakeCoroutine(std::forward<Keys>(keys)...);
+    }
+
+    /// Creates a precompiled path to a nested global value, for fast repeated access.
+    /// \tparam Keys Key types (integer/string).
+    /// \param keys Keys from outermost to innermost.
+    /// \return A new moon Path.
+    template <typename... Keys>
+    static inline moon::Path MakePath(Keys&&... keys) {
+        return s_state->MakePath(std::forward<Keys>(keys)...);
+    }
+
+    /// Creates a registry of script files reloaded in place when changed.
+    /// \return A new moon ScriptRegistry.
+    static inline moon::ScriptRegistry MakeScriptRegistry() { return s_state->MakeScriptRegistry(); }
+
+    /// Interns a global or field name, for fast repeated access without hashing it again.
+    /// \param name Key name.
+    /// \return A new moon InternedKey.
+    static inline moon::InternedKey MakeKey(std::string_view name) { return s_state->MakeKey(name); }
 
     /// Prints element at specified index. Shows value when possible or type otherwise.
     /// \param index Index in stack to print.
     /// \return String log of element.
-    static std::string StackElementToStringDump(int index) {
-        if (!IsValidIndex(index)) {
-            moon::Logger::Warning("tried to print element at invalid index");
-            return "";
-        }
-        index = ConvertNegativeIndex(index);
-
-        static auto printArray = [](int index, size_t size) -> std::string {
-            std::stringstream dump;
-            dump << "[";
-            for (size_t i = 1; i <= size; ++i) {
-                lua_pushinteger(s_state, i);
-                lua_gettable(s_state, index);
-                int top = GetTop();
-                if (lua_type(s_state, top) == LUA_TNIL) {
-                    break;
-                }
-                dump << StackElementToStringDump(top);
-                if (i + 1 <= size) {
-                    dump << ", ";
-                }
-                Pop();
-            }
-            dump << "]";
-            return dump.str();
-        };
-
-        static auto printMap = [](int index) -> std::string {
-            std::stringstream dump;
-            dump << "{";
-            PushNull();
-            bool first = true;
-            while (lua_next(s_state, index) != 0) {
-                if (!first) {
-                    dump << ", ";
-                }
-                first = false;
-                dump << "\"" << Get<std::string>(-2) << "\": " << StackElementToStringDump(GetTop());
-                Pop();
-            }
-            dump << "}";
-            return dump.str();
-        };
-
-        moon::LuaType type = GetType(index);
-        switch (type) {
-            case moon::LuaType::Boolean: {
-                return Get<bool>(index) ? "true" : "false";
-            }
-            case moon::LuaType::Number: {
-                return std::to_string(Get<double>(index));
-            }
-            case moon::LuaType::String: {
-                return "\"" + Get<std::string>(index) + "\"";
-            }
-            case moon::LuaType::Table: {
-                auto size = (size_t)lua_rawlen(s_state, index);
-                return size > 0 ? printArray(index, size) : printMap(index);
-            }
-            default: {  // NOTE(mpinto): Other values, print type
-                return lua_typename(s_state, (int)type);
-            }
-        }
-    }
+    static inline std::string StackElementToStringDump(int index) { return s_state->StackElementToStringDump(index); }
 
     /// Returns current Lua stack as string. Tries to show values when possible or types otherwise.
     /// \return String containing all current Lua stack elements.
-    static std::string GetStackDump() {
-        int top = GetTop();
-        std::stringstream dump;
-        dump << "***** LUA STACK *****" << std::endl;
-        for (int i = 1; i <= top; ++i) {
-            int invertedIndex = top - i + 1;
-            dump << i << " (-" << invertedIndex << ") => " << StackElementToStringDump(i) << std::endl;
-        }
-        return dump.str();
-    }
+    static inline std::string GetStackDump() { return s_state->GetStackDump(); }
 
     /// Logs current stack to logger.
-    static inline void LogStackDump() { moon::Logger::Info(GetStackDump()); }
+    static inline void LogStackDump() { s_state->LogStackDump(); }
 
     /// Ensures that a given LuaMap contains all desired keys. Useful, since maps obtained from lua are dynamic.
     /// \tparam T LuaMap type.
@@ -373,22 +429,8 @@ public:
     }
 
 private:
-    /// Checks for lua status and returns if ok or not.
-    /// \param status Status code obtained from lua function.
-    /// \param errMessage Default error message to print if none is obtained from lua stack.
-    /// \return Whether or not no error occurred.
-    static bool checkStatus(int status, const char* errMessage = "") {
-        if (status != LUA_OK) {
-            const auto* msg = Get<const char*>(-1);
-            Pop();
-            moon::Logger::Error(msg != nullptr ? msg : errMessage);
-            return false;
-        }
-        return true;
-    }
-
-    /// Lua state with static storage.
-    static inline lua_State* s_state{nullptr};
+    /// Default Moon state with static storage.
+    static inline std::optional<moon::State> s_state{};
 };
 
 #endif
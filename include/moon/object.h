@@ -10,13 +10,16 @@ public:
 
     Object() = default;
 
-    explicit Object(lua_State* L) : m_state(L), Reference(L, -1) {}
+    explicit Object(lua_State* L) : Reference(L, -1), m_state(L) {}
 
-    Object(lua_State* L, int index) : m_state(L), Reference(L, index) {}
+    Object(lua_State* L, int index) : Reference(L, index), m_state(L) {}
 
-    Object(const Object& other) : m_state(other.m_state), Reference(other.copy()) {}
+    Object(const Object& other) { acquire(other); }
 
-    Object(Object&& other) noexcept : m_state(other.m_state), Reference(std::move(other)) { other.m_state = nullptr; }
+    Object(Object&& other) noexcept : Reference(std::move(other)), m_state(other.m_state), m_shares(other.m_shares) {
+        other.m_state = nullptr;
+        other.m_shares = nullptr;
+    }
 
     ~Object() {
         if (m_state == nullptr) {
@@ -29,24 +32,39 @@ public:
         if (&other == this) {
             return *this;
         }
-        m_key = other.copy();
-        m_state = other.m_state;
+        Unload();
+        acquire(other);
         return *this;
     }
 
     Object& operator=(Object&& other) noexcept {
+        if (&other == this) {
+            return *this;
+        }
+        Unload();
         m_key = other.m_key;
         m_state = other.m_state;
+        m_shares = other.m_shares;
         other.m_key = LUA_NOREF;
         other.m_state = nullptr;
+        other.m_shares = nullptr;
         return *this;
     }
 
+    /// Assigns a new value. Registry slot is reused when not shared with other objects.
     template <typename T>
     std::enable_if_t<!meta::is_moon_reference_v<T>, Object&> operator=(T&& other) {
-        Unload();
         Core::Push(m_state, std::forward<T>(other));
+        if (IsLoaded() && !lua_isnil(m_state, -1) && (m_shares == nullptr || *m_shares == 1)) {  // Nil would free slot for reuse
+            lua_rawseti(m_state, LUA_REGISTRYINDEX, m_key);
+            return *this;
+        }
+        bool shared = m_shares != nullptr;
+        Unload();
         m_key = luaL_ref(m_state, LUA_REGISTRYINDEX);
+        if (shared) {
+            Share();
+        }
         return *this;
     }
 
@@ -62,8 +80,37 @@ public:
     /// \return Type of ref stored.
     [[nodiscard]] LuaType GetType() const { return Reference::GetType(m_state); }
 
-    /// Unloads reference from lua metatable and resets key.
-    void Unload() { Reference::Unload(m_state); }
+    /// Unloads reference from lua metatable and resets key. Shared references are only unloaded by their last owner.
+    void Unload() {
+        if (m_shares != nullptr) {
+            if (--*m_shares == 0) {
+                delete m_shares;
+                Reference::Unload(m_state);
+            }
+            m_key = LUA_NOREF;
+            m_shares = nullptr;
+            return;
+        }
+        Reference::Unload(m_state);
+    }
+
+    /// Switches object to shared mode, where copies share the same registry slot instead of creating new references. Use count is not
+    /// atomic, as Lua states are not thread safe either.
+    /// \return This object.
+    Object& Share() {
+        if (IsLoaded() && m_shares == nullptr) {
+            m_shares = new size_t{1};
+        }
+        return *this;
+    }
+
+    /// Checks if object is in shared mode.
+    /// \return Whether or not registry slot is shared between copies.
+    [[nodiscard]] inline bool IsShared() const { return m_shares != nullptr; }
+
+    /// Getter for number of objects sharing the registry slot.
+    /// \return Use count. 1 for loaded unique objects and 0 if not loaded.
+    [[nodiscard]] inline size_t GetUseCount() const { return m_shares != nullptr ? *m_shares : (size_t)IsLoaded(); }
 
     /// Push value to stack. Returns number of values pushed.
     int Push() const { return Reference::Push(m_state); }
@@ -94,6 +141,21 @@ public:
         return Core::Get<Ret>(m_state, -1);
     }
 
+    /// Gets sibling fields of table object, pushing it only once.
+    /// \tparam Rets Types of fields.
+    /// \tparam Keys Types of keys.
+    /// \param keys Field keys, one per type.
+    /// \return Field value or tuple of values.
+    template <typename... Rets, typename... Keys>
+    decltype(auto) GetFields(Keys&&... keys) const {
+        if (!IsLoaded()) {
+            return Core::DefaultReturnWithError<std::decay_t<Rets>...>("tried to get fields from an Object not loaded");
+        }
+        Push();
+        Stack::PopGuard guard{m_state};
+        return Core::GetFields<Rets...>(m_state, -1, std::forward<Keys>(keys)...);
+    }
+
     /// Calls object if function reference.
     /// \tparam Rets Return(s) type(s).
     /// \tparam Args Arguments types.
@@ -140,20 +202,26 @@ public:
 
 private:
     /// Will save top stack element as ref and pop it, messing with stack. To still leave a copy in stack, explicit specify element index.
-    Object(lua_State* L, std::true_type) : m_state(L), Reference(luaL_ref(L, LUA_REGISTRYINDEX)) {}
+    Object(lua_State* L, std::true_type) : Reference(luaL_ref(L, LUA_REGISTRYINDEX)), m_state(L) {}
 
-    /// Copies reference in lua ref holder table.
-    /// \return Key id of newly created copy.
-    [[nodiscard]] int copy() const {
-        if (!IsLoaded()) {
-            return LUA_NOREF;
+    /// Copies reference in lua ref holder table, or shares it when in shared mode. Expects this object to be unloaded.
+    /// \param other Object to copy from.
+    void acquire(const Object& other) {
+        m_state = other.m_state;
+        if (other.m_shares != nullptr) {
+            m_key = other.m_key;
+            m_shares = other.m_shares;
+            ++*m_shares;
+        } else if (other.IsLoaded()) {
+            other.Push();
+            m_key = luaL_ref(m_state, LUA_REGISTRYINDEX);
         }
-        Push();
-        return luaL_ref(m_state, LUA_REGISTRYINDEX);
     }
 
     /// Lua state.
     lua_State* m_state{nullptr};
+    /// Use count of shared registry slot. Null in unique mode.
+    size_t* m_shares{nullptr};
 };
 
 /// Creates a lambda function (property `functor`) with specified template arguments signature that calls a moon::Object with same signature.
@@ -169,7 +237,8 @@ public:
     /// \return STL function that will call moon object.
     static std::function<Ret(Args...)> GetFunctor(lua_State* L, int index) {
         Object obj(L, index);
-        return [obj](Args&&... args) { return obj.Call<Ret>(std::forward<Args>(args)...); };
+        obj.Share();  // Copies of functor share the reference
+        return [obj = std::move(obj)](Args&&... args) { return obj.Call<Ret>(std::forward<Args>(args)...); };
     }
 };
 }  // namespace moon
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "statepool.h"
+
+namespace moon {
+namespace parallel_detail {
+/// Shared progress of a parallel map. Workers claim chunks of input from an atomic cursor, so faster workers keep taking chunks left by
+/// slower ones. Results are written in place, each index by a single worker. Errors are kept to be logged by calling thread. Results are
+/// read as their own type and only then converted to stored type, e.g. booleans stored as bytes.
+template <typename T, typename R, typename Stored>
+struct MapJob {
+    const std::string& code;
+    const std::vector<T>& input;
+    std::vector<Stored>& output;
+    size_t chunkSize;
+    /// Index of next chunk to claim.
+    std::atomic<size_t> next{0};
+    /// Set on first error, stopping every worker.
+    std::atomic<bool> failed{false};
+    /// Guards error.
+    std::mutex mutex{};
+    /// First error found.
+    std::string error{};
+
+    void Fail(std::string message) {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (!failed.exchange(true)) {
+            error = std::move(message);
+        }
+    }
+
+    /// Maps chunks until input is exhausted or a worker fails.
+    void Run(State& state) {
+        lua_State* L = state.GetState();
+        const Chunk* chunk = state.GetChunkCache().GetCode(code.c_str());
+        if (chunk == nullptr || !chunk->Run(1) || !lua_isfunction(L, -1)) {
+            lua_settop(L, 0);
+            Fail("parallel map source is not a function");
+            return;
+        }
+        int function = lua_gettop(L);
+        while (!failed.load(std::memory_order_relaxed)) {
+            size_t begin = next.fetch_add(chunkSize, std::memory_order_relaxed);
+            if (begin >= input.size()) {
+                break;
+            }
+            size_t end = std::min(begin + chunkSize, input.size());
+            for (size_t i = begin; i < end; ++i) {
+                lua_pushvalue(L, function);
+                Stack::PushValue(L, input[i]);
+                if (lua_pcall(L, 1, 1, 0) != LUA_OK) {
+                    const char* message = lua_tostring(L, -1);
+                    Fail(std::string("parallel map failed: ") + (message != nullptr ? message : "(error object is not a string)"));
+                    lua_settop(L, 0);
+                    return;
+                }
+                auto result = Stack::TryGetValue<R>(L, -1);
+                lua_pop(L, 1);
+                if (!result) {
+                    lua_settop(L, 0);
+                    Fail("parallel map result of element " + std::to_string(i) + " has an unexpected type");
+                    return;
+                }
+                output[i] = Stored(std::move(*result));
+            }
+        }
+        lua_settop(L, 0);
+    }
+};
+}  // namespace parallel_detail
+
+/// Applies a pure Lua function to every element of input, spreading chunks of it across states of pool, each in its own thread. Calling
+/// thread works too, holding the first state acquired, and other threads only use states free at call time. Function is compiled once per
+/// state and cached, so repeated maps skip parsing. Elements are pushed and results read with the usual Stack conversions, without logging
+/// from worker threads. Function must not rely on globals changed by previous maps, since states are reset when returned to pool.
+/// \tparam R Result type.
+/// \tparam T Input element type.
+/// \param pool Pool of states to run function in.
+/// \param source Lua expression evaluating to function, e.g. "function(x) return x * 2 end".
+/// \param input Elements to map.
+/// \param chunkSize Number of elements claimed at a time. 0 picks a size that balances load.
+/// \return Results in input order. Empty on errors.
+template <typename R, typename T>
+std::vector<R> ParallelMap(StatePool& pool, const std::string& source, const std::vector<T>& input, size_t chunkSize = 0) {
+    // Distinct elements of std::vector<bool> share storage, so booleans are gathered as bytes
+    using stored_t = std::conditional_t<std::is_same_v<R, bool>, char, R>;
+    if (input.empty()) {
+        return {};
+    }
+    const std::string code{"return " + source};
+    auto lease = pool.Acquire();
+    if (lease->GetChunkCache().GetCode(code.c_str()) == nullptr) {
+        return Stack::DefaultReturnWithError<std::vector<R>>("failed to compile parallel map source");
+    }
+    size_t workers = std::min(pool.GetAvailable() + 1, input.size());
+    if (chunkSize == 0) {
+        chunkSize = std::max(input.size() / (workers * 8), (size_t)1);
+    }
+
+    std::vector<stored_t> output(input.size());
+    parallel_detail::MapJob<T, R, stored_t> job{code, input, output, chunkSize};
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (size_t i = 1; i < workers; ++i) {
+        threads.emplace_back([&pool, &job]() {
+            if (auto helper = pool.TryAcquire()) {
+                job.Run(*helper);
+            }
+        });
+    }
+    job.Run(*lease);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (job.failed) {
+        return Stack::DefaultReturnWithError<std::vector<R>>(std::move(job.error));
+    }
+    if constexpr (std::is_same_v<R, bool>) {
+        return std::vector<bool>(output.begin(), output.end());
+    } else {
+        return output;
+    }
+}
+
+/// Applies a pure Lua function to every element of input, using a pool created for this call with one state per hardware thread. Prefer
+/// reusing a pool for repeated maps, since creating states is expensive.
+/// \tparam R Result type.
+/// \tparam T Input element type.
+/// \param source Lua expression evaluating to function, e.g. "function(x) return x * 2 end".
+/// \param input Elements to map.
+/// \return Results in input order. Empty on errors.
+template <typename R, typename T>
+std::vector<R> ParallelMap(const std::string& source, const std::vector<T>& input) {
+    StatePool pool{std::max(std::thread::hardware_concurrency(), 1u)};
+    return ParallelMap<R>(pool, source, input);
+}
+}  // namespace moon
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "chunk.h"
+
+namespace moon {
+/// Precompiled path of keys to a nested global value, e.g. `config.window.width`. Keys are interned once, as Lua values referenced in
+/// registry, so repeated accesses do not hash C strings again. Optionally, the parent table of the value is cached, which skips walking
+/// the path altogether. When cached, replacing any table along the path requires Invalidate to be called.
+class Path {
+public:
+    Path() = default;
+
+    /// Creates a path from global scope through provided keys.
+    /// \tparam Keys Key types, either string or integral.
+    /// \param L Lua state.
+    /// \param keys Keys from outermost to innermost.
+    template <typename... Keys>
+    explicit Path(lua_State* L, Keys&&... keys) : m_state(L) {
+        static_assert(sizeof...(Keys) > 0, "a path needs at least one key");
+        m_keys.reserve(sizeof...(Keys));
+        (intern(std::forward<Keys>(keys)), ...);
+    }
+
+    Path(const Path&) = delete;
+
+    Path(Path&& other) noexcept
+        : m_state(other.m_state), m_keys(std::move(other.m_keys)), m_parent(std::move(other.m_parent)), m_cache(other.m_cache) {
+        other.m_state = nullptr;
+        other.m_keys.clear();
+    }
+
+    ~Path() { unload(); }
+
+    Path& operator=(const Path&) = delete;
+
+    Path& operator=(Path&& other) noexcept {
+        if (&other == this) {
+            return *this;
+        }
+        unload();
+        m_state = other.m_state;
+        m_keys = std::move(other.m_keys);
+        m_parent = std::move(other.m_parent);
+        m_cache = other.m_cache;
+        other.m_state = nullptr;
+        other.m_keys.clear();
+        return *this;
+    }
+
+    /// Getter for the Lua state.
+    /// \return Lua state pointer.
+    [[nodiscard]] inline lua_State* GetState() const { return m_state; }
+
+    /// Getter for number of keys in path.
+    /// \return Path depth.
+    [[nodiscard]] inline size_t GetSize() const { return m_keys.size(); }
+
+    /// Enables or disables caching of parent table. Parent is resolved on first access.
+    /// \param enable Whether or not to cache parent table.
+    /// \return This path, for chaining.
+    Path& CacheParent(bool enable = true) {
+        m_cache = enable;
+        if (!enable) {
+            Invalidate();
+        }
+        return *this;
+    }
+
+    /// Checks if parent table is currently cached.
+    /// \return Whether or not parent is cached.
+    [[nodiscard]] inline bool IsCached() const { return m_parent.IsLoaded(); }
+
+    /// Drops cached parent table, which will be resolved again on next access.
+    void Invalidate() {
+        if (m_state != nullptr) {
+            m_parent.Unload(m_state);
+        }
+    }
+
+    /// Gets value at path.
+    /// \tparam R Type of value.
+    /// \return Value. Default constructed on errors.
+    template <typename R>
+    decltype(auto) Get() const {
+        using ret_t = std::decay_t<R>;
+        if (!pushValue()) {
+            return Stack::DefaultReturnWithError<ret_t>("invalid path when getting value");
+        }
+        Stack::PopGuard guard{m_state, 2};
+        return Stack::GetValue<ret_t>(m_state, -1);
+    }
+
+    /// Gets sibling fields of table at path, traversing path only once.
+    /// \tparam Rets Types of fields.
+    /// \tparam Keys Types of keys.
+    /// \param keys Field keys, one per type.
+    /// \return Field value or tuple of values. Default constructed on errors.
+    template <typename... Rets, typename... Keys>
+    decltype(auto) GetFields(Keys&&... keys) const {
+        if (!pushValue()) {
+            return Core::DefaultReturnWithError<std::decay_t<Rets>...>("invalid path when getting fields");
+        }
+        Stack::PopGuard guard{m_state, 2};
+        return Core::GetFields<Rets...>(m_state, -1, std::forward<Keys>(keys)...);
+    }
+
+    /// Sets value at path, creating missing tables along the way.
+    /// \tparam T Type of value.
+    /// \param value Value to set.
+    /// \return Whether or not value was set.
+    template <typename T>
+    bool Set(T&& value) const {
+        if (!pushParent(true)) {
+            return Stack::DefaultReturnWithError<bool>("invalid path when setting value");
+        }
+        Stack::PopGuard guard{m_state, 1};
+        m_keys.back().Push(m_state);
+        Core::Push(m_state, std::forward<T>(value));
+        lua_settable(m_state, -3);
+        return true;
+    }
+
+    /// Getter for type of value at path.
+    /// \return Moon type, null if path is invalid.
+    [[nodiscard]] LuaType GetType() const {
+        if (!pushValue()) {
+            return LuaType::Null;
+        }
+        Stack::PopGuard guard{m_state, 2};
+        return static_cast<LuaType>(lua_type(m_state, -1));
+    }
+
+    /// Checks if value at path is of provided type.
+    /// \tparam T Type to check.
+    /// \return Whether or not value is of type.
+    template <typename T>
+    [[nodiscard]] bool Check() const {
+        if (!pushValue()) {
+            return false;
+        }
+        Stack::PopGuard guard{m_state, 2};
+        return Stack::CheckValue<T>(m_state, -1);
+    }
+
+    /// Sets value at path to nil.
+    void Clean() const {
+        if (!pushParent(false)) {
+            return;
+        }
+        Stack::PopGuard guard{m_state, 1};
+        m_keys.back().Push(m_state);
+        lua_pushnil(m_state);
+        lua_settable(m_state, -3);
+    }
+
+private:
+    /// Pushes key and stores it as a reference.
+    template <typename Key>
+    void intern(Key&& key) {
+        static_assert(meta::is_basic_string_v<Key> || meta::is_integral_v<Key>, "path keys must be strings or integers");
+        Stack::PushValue(m_state, std::forward<Key>(key));
+        m_keys.emplace_back(m_state);
+        lua_pop(m_state, 1);
+    }
+
+    /// Pushes parent table to stack, either from cache or by walking path.
+    /// \param create Whether or not missing tables should be created.
+    /// \return Whether or not parent was pushed. Nothing is pushed on failure.
+    bool pushParent(bool create) const {
+        if (m_state == nullptr || m_keys.empty()) {
+            return false;
+        }
+        if (m_parent.IsLoaded()) {
+            m_parent.Push(m_state);
+            return true;
+        }
+        lua_pushglobaltable(m_state);
+        for (size_t i = 0; i + 1 < m_keys.size(); ++i) {
+            m_keys[i].Push(m_state);
+            lua_gettable(m_state, -2);
+            if (lua_isnil(m_state, -1) && create) {
+                lua_pop(m_state, 1);
+                lua_newtable(m_state);
+                m_keys[i].Push(m_state);
+                lua_pushvalue(m_state, -2);
+                lua_settable(m_state, -4);
+            }
+            lua_remove(m_state, -2);
+            if (!lua_istable(m_state, -1)) {
+                lua_pop(m_state, 1);
+                return false;
+            }
+        }
+        if (m_cache) {
+            m_parent = Reference{m_state, -1};
+        }
+        return true;
+    }
+
+    /// Pushes parent table and value to stack.
+    /// \return Whether or not both were pushed. Nothing is pushed on failure.
+    bool pushValue() const {
+        if (!pushParent(false)) {
+            return false;
+        }
+        m_keys.back().Push(m_state);
+        lua_gettable(m_state, -2);
+        return true;
+    }
+
+    /// Releases all references.
+    void unload() {
+        if (m_state == nullptr) {
+            return;
+        }
+        for (auto& key : m_keys) {
+            key.Unload(m_state);
+        }
+        m_keys.clear();
+        m_parent.Unload(m_state);
+    }
+
+    /// Lua state.
+    lua_State* m_state{nullptr};
+    /// Interned keys.
+    std::vector<Reference> m_keys;
+    /// Cached parent table.
+    mutable Reference m_parent;
+    /// Whether or not parent table should be cached.
+    bool m_cache{false};
+};
+}  // namespace moon
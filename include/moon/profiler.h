@@ -0,0 +1,329 @@
+#pragma once
+
+#include "allocator.h"
+#include "logger.h"
+
+namespace moon {
+constexpr const char* LUA_SAMPLING_PROFILER_KEY{"MoonSamplingProfiler"};
+
+/// Kinds of instrumented call sites.
+enum class ProfileCategory { Function, Method, Property, Call };
+
+/// Aggregated statistics of an instrumented call site. Counters are atomic, since states living in different threads share call sites.
+struct CallStats {
+    /// Number of calls.
+    std::atomic<uint64_t> calls{0};
+    /// Cumulative time spent, in nanoseconds.
+    std::atomic<uint64_t> nanoseconds{0};
+    /// Cumulative number of allocations done by Lua state. Only counted for states with a moon::Allocator.
+    std::atomic<uint64_t> allocations{0};
+};
+
+/// Snapshot of the statistics of a call site.
+struct CallRecord {
+    ProfileCategory category;
+    std::string name;
+    uint64_t calls;
+    uint64_t nanoseconds;
+    uint64_t allocations;
+};
+
+/// Opt-in instrumentation of calls across the C++/Lua boundary: registered functions, bound class methods and properties and calls to
+/// Lua functions. Enabled by defining MOON_INSTRUMENTATION, through the CMake option of the same name. When disabled, every hook is
+/// discarded at compile time.
+class Profiler {
+public:
+#ifdef MOON_INSTRUMENTATION
+    static constexpr bool s_enabled{true};
+#else
+    static constexpr bool s_enabled{false};
+#endif
+
+    /// Start of a measured call. Trivially destructible, so a Lua error jumping over a measured call only skips its record.
+    struct Sample {
+        std::chrono::steady_clock::time_point start{};
+        size_t allocations{0};
+    };
+
+    /// Measures a call for as long as it lives. Only suited for calls that cannot raise Lua errors, e.g. protected calls.
+    class Scope {
+    public:
+        /// Starts measuring a call.
+        /// \param L Lua state.
+        /// \param stats Call site statistics. Nothing is recorded if null.
+        Scope(lua_State* L, CallStats* stats) : m_state(L), m_stats(stats), m_sample(Begin(L)) {}
+
+        Scope(const Scope&) = delete;
+
+        Scope(Scope&&) = delete;
+
+        ~Scope() { End(m_state, m_stats, m_sample); }
+
+        Scope& operator=(const Scope&) = delete;
+
+        Scope& operator=(Scope&&) = delete;
+
+    private:
+        lua_State* m_state;
+        CallStats* m_stats;
+        Sample m_sample;
+    };
+
+    /// Getter for statistics of a call site, created on first use. Returned reference stays valid until program ends.
+    /// \tparam Key Name type. String or number.
+    /// \param category Kind of call site.
+    /// \param key Name of call site.
+    /// \return Call site statistics.
+    template <typename Key>
+    static CallStats& Get(ProfileCategory category, Key&& key) {
+        if constexpr (std::is_arithmetic_v<std::decay_t<Key>>) {
+            return find(category, std::to_string(key));
+        } else {
+            return find(category, std::string_view{key});
+        }
+    }
+
+    /// Starts measuring a call.
+    /// \param L Lua state.
+    /// \return Sample to end measure with.
+    static inline Sample Begin(lua_State* L) {
+        if constexpr (s_enabled) {
+            return {std::chrono::steady_clock::now(), allocations(L)};
+        } else {
+            return {};
+        }
+    }
+
+    /// Ends measuring a call, adding it to call site statistics.
+    /// \param L Lua state.
+    /// \param stats Call site statistics. Nothing is recorded if null.
+    /// \param sample Sample returned by Begin.
+    static inline void End(lua_State* L, CallStats* stats, const Sample& sample) {
+        if constexpr (s_enabled) {
+            if (stats == nullptr) {
+                return;
+            }
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sample.start);
+            stats->calls.fetch_add(1, std::memory_order_relaxed);
+            stats->nanoseconds.fetch_add((uint64_t)elapsed.count(), std::memory_order_relaxed);
+            stats->allocations.fetch_add(allocations(L) - sample.allocations, std::memory_order_relaxed);
+        }
+    }
+
+    /// Ends measuring a call of a C closure that keeps its call site statistics as light userdata upvalue.
+    /// \param L Lua state.
+    /// \param upvalue Pseudo index of upvalue.
+    /// \param sample Sample returned by Begin.
+    static inline void End(lua_State* L, int upvalue, const Sample& sample) {
+        if constexpr (s_enabled) {
+            End(L, static_cast<CallStats*>(lua_touserdata(L, upvalue)), sample);
+        }
+    }
+
+    /// Getter for statistics of every call site used so far.
+    /// \return Records sorted by cumulative time, descending.
+    static std::vector<CallRecord> GetRecords() {
+        std::vector<CallRecord> records;
+        std::lock_guard<std::mutex> lock{s_mutex};
+        for (size_t category = 0; category < s_stats.size(); ++category) {
+            for (const auto& [name, stats] : s_stats[category]) {
+                records.push_back({(ProfileCategory)category, name, stats.calls.load(), stats.nanoseconds.load(), stats.allocations.load()});
+            }
+        }
+        std::sort(records.begin(), records.end(), [](const auto& a, const auto& b) { return a.nanoseconds > b.nanoseconds; });
+        return records;
+    }
+
+    /// Zeroes statistics of every call site. Call sites are kept, since closures hold them.
+    static void Reset() {
+        std::lock_guard<std::mutex> lock{s_mutex};
+        for (auto& category : s_stats) {
+            for (auto& [name, stats] : category) {
+                stats.calls = 0;
+                stats.nanoseconds = 0;
+                stats.allocations = 0;
+            }
+        }
+    }
+
+private:
+    static CallStats& find(ProfileCategory category, std::string_view name) {
+        std::lock_guard<std::mutex> lock{s_mutex};
+        auto& stats = s_stats[(size_t)category];
+        auto it = stats.find(name);
+        if (it == stats.end()) {
+            it = stats.try_emplace(std::string{name}).first;
+        }
+        return it->second;
+    }
+
+    /// Number of allocations done by state, if it uses a moon::Allocator.
+    static size_t allocations(lua_State* L) {
+        void* ud = nullptr;
+        if (lua_getallocf(L, &ud) != &Allocator::Allocate) {
+            return 0;
+        }
+        return static_cast<Allocator*>(ud)->GetAllocations();
+    }
+
+    /// Guards call sites creation and snapshots.
+    static inline std::mutex s_mutex{};
+    /// Call sites statistics per category. Nodes are stable, so references are handed out.
+    static inline std::array<std::map<std::string, CallStats, std::less<>>, 4> s_stats{};
+};
+
+/// Samples Lua call stacks every given number of VM instructions, through a count hook. Aggregates source line hotspots and folded
+/// stacks, the input format of flamegraph.pl and compatible tools. Coroutines created while sampling inherit the hook and are sampled
+/// too. Lua allows a single hook per thread, so sampling is refused if another hook is installed.
+class SamplingProfiler {
+public:
+    /// Deepest stack level sampled.
+    static constexpr int s_maxDepth{64};
+
+    explicit SamplingProfiler(lua_State* L) : m_state(L) {}
+
+    SamplingProfiler(const SamplingProfiler&) = delete;
+
+    SamplingProfiler(SamplingProfiler&&) = delete;
+
+    ~SamplingProfiler() { Stop(); }
+
+    SamplingProfiler& operator=(const SamplingProfiler&) = delete;
+
+    SamplingProfiler& operator=(SamplingProfiler&&) = delete;
+
+    /// Starts sampling.
+    /// \param interval Number of VM instructions between samples.
+    /// \return Whether or not sampling started.
+    bool Start(int interval = 1000) {
+        if (m_running) {
+            return true;
+        }
+        if (lua_gethook(m_state) != nullptr) {
+            Logger::Error("tried to start sampling profiler while another hook is installed");
+            return false;
+        }
+        lua_pushlightuserdata(m_state, this);
+        lua_setfield(m_state, LUA_REGISTRYINDEX, LUA_SAMPLING_PROFILER_KEY);
+        lua_sethook(m_state, &SamplingProfiler::hook, LUA_MASKCOUNT, std::max(interval, 1));
+        m_running = true;
+        return true;
+    }
+
+    /// Stops sampling. Samples are kept.
+    void Stop() {
+        if (!m_running) {
+            return;
+        }
+        lua_sethook(m_state, nullptr, 0, 0);
+        lua_pushnil(m_state);
+        lua_setfield(m_state, LUA_REGISTRYINDEX, LUA_SAMPLING_PROFILER_KEY);
+        m_running = false;
+    }
+
+    /// Discards samples taken so far.
+    void Reset() {
+        m_samples = 0;
+        m_hotspots.clear();
+        m_stacks.clear();
+    }
+
+    /// Checks if profiler is sampling.
+    /// \return Whether or not sampling is running.
+    [[nodiscard]] inline bool IsRunning() const { return m_running; }
+
+    /// Getter for number of samples taken.
+    /// \return Number of samples.
+    [[nodiscard]] inline size_t GetSampleCount() const { return m_samples; }
+
+    /// Getter for source lines being executed when samples were taken.
+    /// \return Pairs of "source:line" and samples, sorted by samples, descending.
+    [[nodiscard]] std::vector<std::pair<std::string, size_t>> GetHotspots() const {
+        std::vector<std::pair<std::string, size_t>> hotspots{m_hotspots.begin(), m_hotspots.end()};
+        std::stable_sort(hotspots.begin(), hotspots.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+        return hotspots;
+    }
+
+    /// Dumps samples as folded stacks, one "root;...;leaf samples" line per distinct stack.
+    /// \return Folded stacks.
+    [[nodiscard]] std::string Dump() const {
+        std::string dump;
+        for (const auto& [stack, samples] : m_stacks) {
+            dump.append(stack).append(" ").append(std::to_string(samples)).append("\n");
+        }
+        return dump;
+    }
+
+    /// Writes folded stacks to a file.
+    /// \param path File path.
+    /// \return Whether or not file was written.
+    bool Save(const std::string& path) const {
+        std::ofstream file{path};
+        if (!file) {
+            Logger::Error("failed to open sampling profiler output file " + path);
+            return false;
+        }
+        file << Dump();
+        return (bool)file;
+    }
+
+private:
+    static void hook(lua_State* L, lua_Debug* ar) {
+        if (ar->event != LUA_HOOKCOUNT) {
+            return;
+        }
+        lua_getfield(L, LUA_REGISTRYINDEX, LUA_SAMPLING_PROFILER_KEY);
+        auto* self = static_cast<SamplingProfiler*>(lua_touserdata(L, -1));
+        lua_pop(L, 1);
+        if (self != nullptr) {  // Threads inherit hook, even after sampling stops
+            self->sample(L);
+        }
+    }
+
+    void sample(lua_State* L) {
+        lua_Debug ar;
+        m_frames.clear();
+        for (int level = 0; level < s_maxDepth && lua_getstack(L, level, &ar) != 0; ++level) {
+            lua_getinfo(L, "Sln", &ar);
+            if (m_frames.empty() && ar.currentline > 0) {
+                ++m_hotspots[std::string{ar.short_src}.append(":").append(std::to_string(ar.currentline))];
+            }
+            m_frames.emplace_back(frame(ar));
+        }
+        std::string stack;
+        for (auto it = m_frames.rbegin(); it != m_frames.rend(); ++it) {
+            if (!stack.empty()) {
+                stack.append(";");
+            }
+            stack.append(*it);
+        }
+        ++m_stacks[stack];
+        ++m_samples;
+    }
+
+    /// Frame name, with source location of Lua functions. Semicolons separate folded frames, so they are replaced.
+    static std::string frame(const lua_Debug& ar) {
+        std::string frame{ar.name != nullptr ? ar.name : (*ar.what == 'm' ? "main chunk" : "?")};
+        if (*ar.what == 'C') {
+            frame.append(" [C]");
+        } else {
+            frame.append(" (").append(ar.short_src).append(":").append(std::to_string(ar.linedefined)).append(")");
+        }
+        std::replace(frame.begin(), frame.end(), ';', ',');
+        return frame;
+    }
+
+    /// Lua state.
+    lua_State* m_state{nullptr};
+    /// Whether or not hook is installed.
+    bool m_running{false};
+    /// Number of samples taken.
+    size_t m_samples{0};
+    /// Samples per source line.
+    std::unordered_map<std::string, size_t> m_hotspots;
+    /// Samples per folded stack. Ordered, so dumps are stable.
+    std::map<std::string, size_t> m_stacks;
+    /// Frames of stack being sampled, leaf first. Kept to reuse its storage.
+    std::vector<std::string> m_frames;
+};
+}  // namespace moon
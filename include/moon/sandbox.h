@@ -0,0 +1,265 @@
+#pragma once
+
+#include "chunk.h"
+
+namespace moon {
+constexpr const char* LUA_SANDBOX_KEY{"MoonSandbox"};
+
+/// Outcome of sandboxed code.
+enum class SandboxStatus {
+    /// Code ran to completion.
+    Ok,
+    /// Code failed to load or raised an error.
+    Error,
+    /// Code ran more VM instructions than its budget.
+    InstructionLimit,
+    /// Code ran past its wallclock deadline and was preempted.
+    Timeout,
+    /// Code tried to use more memory than its cap.
+    MemoryLimit
+};
+
+/// Resource limits of sandboxed code. A zero leaves resource unbounded.
+struct SandboxLimits {
+    /// Maximum number of VM instructions. Counted every Sandbox::s_hookInterval instructions, so overruns are bounded by it.
+    uint64_t instructions{0};
+    /// Maximum wallclock time. Checked along with instructions, so time spent inside a single C function is not preempted.
+    std::chrono::milliseconds timeout{0};
+    /// Maximum number of bytes in use by state, including memory in use before running. Needs state to use a moon::Allocator.
+    size_t memory{0};
+};
+
+/// Runs untrusted code with bounded instructions, time and memory, through a count hook and the state allocator. A budget overrun raises
+/// an error that propagates through protected calls too, since hook fires on every instruction from then on. Lua allows a single hook per
+/// thread, so running is refused if another hook is installed. Coroutines created by sandboxed code inherit its limits.
+class Sandbox {
+public:
+    /// Standard libraries, as flags to pick which ones a state opens.
+    enum Libraries : unsigned {
+        Base = 0x001,
+        Package = 0x002,
+        Coroutine = 0x004,
+        Table = 0x008,
+        IO = 0x010,
+        OS = 0x020,
+        String = 0x040,
+        Math = 0x080,
+        UTF8 = 0x100,
+        Debug = 0x200,
+        /// Libraries with no access to files, processes or internals.
+        Safe = Base | Coroutine | Table | String | Math | UTF8,
+        All = 0x3ff
+    };
+
+    /// Number of VM instructions between checks of limits.
+    static constexpr int s_hookInterval{1000};
+
+    /// Opens selected standard libraries. Without IO, base functions that read files, dofile and loadfile, are removed too. Unless all
+    /// libraries are opened, base load only accepts text chunks, since malformed bytecode can crash the interpreter.
+    /// \param L Lua state.
+    /// \param libraries Flags of libraries to open.
+    static void OpenLibraries(lua_State* L, unsigned libraries) {
+        if ((libraries & All) == All) {
+            luaL_openlibs(L);
+            return;
+        }
+        static constexpr std::array<std::tuple<unsigned, const char*, lua_CFunction>, 10> libs{{
+            {Base, LUA_GNAME, &luaopen_base},
+            {Package, LUA_LOADLIBNAME, &luaopen_package},
+            {Coroutine, LUA_COLIBNAME, &luaopen_coroutine},
+            {Table, LUA_TABLIBNAME, &luaopen_table},
+            {IO, LUA_IOLIBNAME, &luaopen_io},
+            {OS, LUA_OSLIBNAME, &luaopen_os},
+            {String, LUA_STRLIBNAME, &luaopen_string},
+            {Math, LUA_MATHLIBNAME, &luaopen_math},
+            {UTF8, LUA_UTF8LIBNAME, &luaopen_utf8},
+            {Debug, LUA_DBLIBNAME, &luaopen_debug},
+        }};
+        for (const auto& [flag, name, open] : libs) {
+            if ((libraries & flag) != 0) {
+                luaL_requiref(L, name, open, 1);
+                lua_pop(L, 1);
+            }
+        }
+        if ((libraries & Base) != 0 && (libraries & IO) == 0) {
+            lua_pushnil(L);
+            lua_setglobal(L, "dofile");
+            lua_pushnil(L);
+            lua_setglobal(L, "loadfile");
+        }
+        if ((libraries & Base) != 0) {
+            lua_getglobal(L, "load");
+            lua_pushcclosure(L, &Sandbox::textLoad, 1);
+            lua_setglobal(L, "load");
+        }
+    }
+
+    /// Creates a sandbox running code in state.
+    /// \param L Lua state.
+    /// \param limits Resource limits of each run.
+    Sandbox(lua_State* L, const SandboxLimits& limits) : m_state(L), m_limits(limits) {}
+
+    Sandbox(const Sandbox&) = delete;
+
+    Sandbox(Sandbox&&) = delete;
+
+    ~Sandbox() = default;
+
+    Sandbox& operator=(const Sandbox&) = delete;
+
+    Sandbox& operator=(Sandbox&&) = delete;
+
+    /// Runs Lua code snippet within limits. Only text is accepted, since malformed bytecode can crash the interpreter.
+    /// \param code Code to run.
+    /// \return Outcome of code.
+    SandboxStatus RunCode(const char* code) {
+        if (luaL_loadbufferx(m_state, code, strlen(code), code, "t") != LUA_OK) {
+            return failed("Error running sandboxed code");
+        }
+        return call();
+    }
+
+    /// Loads specified file script within limits. Only text files are accepted, since malformed bytecode can crash the interpreter.
+    /// \param filePath File path to load.
+    /// \return Outcome of file.
+    SandboxStatus LoadFile(const char* filePath) {
+        if (luaL_loadfilex(m_state, filePath, "t") != LUA_OK) {
+            return failed("Error loading sandboxed file");
+        }
+        return call();
+    }
+
+    /// Runs compiled chunk within limits.
+    /// \param chunk Chunk to run.
+    /// \return Outcome of chunk.
+    SandboxStatus Run(const Chunk& chunk) {
+        if (!chunk.IsLoaded()) {
+            Logger::Error("tried to run a chunk not loaded");
+            return SandboxStatus::Error;
+        }
+        chunk.Reference::Push(m_state);
+        return call();
+    }
+
+    /// Getter for resource limits.
+    /// \return Limits of each run.
+    [[nodiscard]] inline const SandboxLimits& GetLimits() const { return m_limits; }
+
+    /// Setter for resource limits, used from next run on.
+    /// \param limits Limits of each run.
+    inline void SetLimits(const SandboxLimits& limits) { m_limits = limits; }
+
+    /// Getter for number of instructions ran by last run, in steps of hook interval.
+    /// \return Number of instructions.
+    [[nodiscard]] inline uint64_t GetInstructions() const { return m_instructions; }
+
+private:
+    /// Calls function at top of stack with hook and memory cap in place.
+    SandboxStatus call() {
+        if (lua_gethook(m_state) != nullptr) {
+            lua_pop(m_state, 1);
+            Logger::Error("tried to run sandboxed code while another hook is installed");
+            return SandboxStatus::Error;
+        }
+        m_instructions = 0;
+        m_status = SandboxStatus::Ok;
+        m_deadline = std::chrono::steady_clock::now() + m_limits.timeout;
+
+        void* ud = nullptr;
+        Allocator* allocator = lua_getallocf(m_state, &ud) == &Allocator::Allocate ? static_cast<Allocator*>(ud) : nullptr;
+        size_t limit = 0;
+        size_t failures = 0;
+        if (m_limits.memory != 0) {
+            if (allocator != nullptr) {
+                limit = allocator->GetLimit();
+                failures = allocator->GetFailures();
+                allocator->SetLimit(m_limits.memory);
+            } else {
+                Logger::Warning("sandbox memory cap ignored, since state does not use a moon::Allocator");
+            }
+        }
+        bool hooked = m_limits.instructions != 0 || m_limits.timeout.count() != 0;
+        if (hooked) {
+            lua_pushlightuserdata(m_state, this);
+            lua_setfield(m_state, LUA_REGISTRYINDEX, LUA_SANDBOX_KEY);
+            uint64_t interval = m_limits.instructions != 0 ? std::min<uint64_t>(m_limits.instructions, s_hookInterval) : s_hookInterval;
+            lua_sethook(m_state, &Sandbox::hook, LUA_MASKCOUNT, (int)interval);
+        }
+
+        int status = lua_pcall(m_state, 0, 0, 0);
+
+        if (hooked) {
+            lua_sethook(m_state, nullptr, 0, 0);
+            lua_pushnil(m_state);
+            lua_setfield(m_state, LUA_REGISTRYINDEX, LUA_SANDBOX_KEY);
+        }
+        bool capped = m_limits.memory != 0 && allocator != nullptr;
+        if (capped) {
+            allocator->SetLimit(limit);
+        }
+        if (status == LUA_OK) {
+            return SandboxStatus::Ok;
+        }
+        if (m_status == SandboxStatus::Ok) {
+            bool refused = capped && allocator->GetFailures() > failures;
+            m_status = status == LUA_ERRMEM || refused ? SandboxStatus::MemoryLimit : SandboxStatus::Error;
+        }
+        return failed("Sandboxed code failed", m_status);
+    }
+
+    /// Base load, original one as upvalue, forcing text mode. Optional environment argument is forwarded only when given.
+    static int textLoad(lua_State* L) {
+        int args = lua_gettop(L) >= 4 ? 4 : 3;
+        lua_settop(L, args);
+        lua_pushliteral(L, "t");
+        lua_replace(L, 3);
+        lua_pushvalue(L, lua_upvalueindex(1));
+        lua_insert(L, 1);
+        lua_call(L, args, LUA_MULTRET);
+        return lua_gettop(L);
+    }
+
+    /// Logs and pops error message at top of stack.
+    SandboxStatus failed(const char* errMessage, SandboxStatus status = SandboxStatus::Error) {
+        const char* msg = lua_tostring(m_state, -1);
+        Logger::Error(std::string(errMessage).append(": ").append(msg != nullptr ? msg : "(error object is not a string)"));
+        lua_pop(m_state, 1);
+        return status;
+    }
+
+    static void hook(lua_State* L, lua_Debug* ar) {
+        if (ar->event != LUA_HOOKCOUNT) {
+            return;
+        }
+        lua_getfield(L, LUA_REGISTRYINDEX, LUA_SANDBOX_KEY);
+        auto* self = static_cast<Sandbox*>(lua_touserdata(L, -1));
+        lua_pop(L, 1);
+        if (self == nullptr) {  // Threads inherit hook, even after run ends
+            return;
+        }
+        if (self->m_status == SandboxStatus::Ok) {
+            self->m_instructions += (uint64_t)lua_gethookcount(L);
+            if (self->m_limits.instructions != 0 && self->m_instructions >= self->m_limits.instructions) {
+                self->m_status = SandboxStatus::InstructionLimit;
+            } else if (self->m_limits.timeout.count() != 0 && std::chrono::steady_clock::now() >= self->m_deadline) {
+                self->m_status = SandboxStatus::Timeout;
+            } else {
+                return;
+            }
+            lua_sethook(L, &Sandbox::hook, LUA_MASKCOUNT, 1);  // Keep raising, so protected calls in code can not swallow overrun
+        }
+        luaL_error(L, self->m_status == SandboxStatus::Timeout ? "sandbox deadline exceeded" : "sandbox instruction budget exceeded");
+    }
+
+    /// Lua state.
+    lua_State* m_state{nullptr};
+    /// Resource limits of each run.
+    SandboxLimits m_limits;
+    /// Instructions ran by current or last run.
+    uint64_t m_instructions{0};
+    /// Deadline of current run.
+    std::chrono::steady_clock::time_point m_deadline{};
+    /// Limit hit by current or last run, Ok if none.
+    SandboxStatus m_status{SandboxStatus::Ok};
+};
+}  // namespace moon
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "chunk.h"
+
+namespace moon {
+/// Registry of script files run as modules, reloaded in place when files change instead of rebuilding the whole state. Each script runs
+/// with its own module table as environment, falling back to globals, so globals it defines become fields of the module. The module
+/// table is also set as a global and in package.loaded under script name. Reloads run scripts again into the same module table, so
+/// references to module, to values it did not reassign and to classes registered in state stay valid. Scripts are compiled through a
+/// chunk cache owned by registry and polled for changes with their modification time and size.
+class ScriptRegistry {
+public:
+    ScriptRegistry() = default;
+
+    explicit ScriptRegistry(lua_State* L) : m_state(L), m_chunks(L) {}
+
+    /// Registers script file as a module and runs it.
+    /// \param name Module name, also set as global.
+    /// \param filePath File path of script.
+    /// \param dependencies Names of registered modules script uses. Script is reloaded along with any of them.
+    /// \return Whether or not script was registered and ran without errors. Script stays registered if it only failed to run.
+    bool Add(const std::string& name, const std::string& filePath, const std::vector<std::string>& dependencies = {}) {
+        if (m_names.count(name) != 0) {
+            Logger::Error("script module " + name + " is already registered");
+            return false;
+        }
+        Script script{name, filePath};
+        for (const auto& dependency : dependencies) {
+            auto it = m_names.find(dependency);
+            if (it == m_names.end()) {
+                Logger::Error("script module " + name + " depends on " + dependency + ", which is not registered");
+                return false;
+            }
+            script.dependencies.push_back(it->second);
+        }
+        script.module = createModule(name);
+        m_names.emplace(name, m_scripts.size());
+        m_scripts.push_back(std::move(script));
+        return run(m_scripts.back());
+    }
+
+    /// Runs again changed scripts and scripts depending on them, in registration order, so dependencies reload first. Unchanged
+    /// scripts are neither compiled nor run. A script failing to compile keeps its previous module and is retried on next reload.
+    /// Changes are detected by modification time, with nanoseconds where platform exposes them, and size. On Windows, or on file systems
+    /// with coarse timestamps, an edit keeping file size within the same timestamp tick is not detected until file changes again.
+    /// \return Number of scripts reloaded without errors.
+    size_t Reload() {
+        size_t reloaded = 0;
+        std::vector<bool> changed(m_scripts.size(), false);
+        for (size_t i = 0; i < m_scripts.size(); ++i) {
+            const auto& script = m_scripts[i];
+            bool dirty = m_chunks.IsModified(script.path.c_str());
+            for (size_t dependency : script.dependencies) {
+                dirty = dirty || changed[dependency];
+            }
+            if (dirty && run(script)) {
+                changed[i] = true;
+                ++reloaded;
+            }
+        }
+        return reloaded;
+    }
+
+    /// Gets module table of script.
+    /// \param name Module name.
+    /// \return Object referencing module. Not loaded if script is not registered.
+    [[nodiscard]] Object GetModule(const std::string& name) const {
+        auto it = m_names.find(name);
+        if (it == m_names.end()) {
+            return Stack::DefaultReturnWithError<Object>("script module " + name + " is not registered");
+        }
+        return m_scripts[it->second].module;
+    }
+
+    /// Checks if a script is registered with name.
+    /// \param name Module name.
+    /// \return Whether or not script is registered.
+    [[nodiscard]] inline bool Contains(const std::string& name) const { return m_names.count(name) != 0; }
+
+    /// Getter for number of registered scripts.
+    /// \return Number of scripts.
+    [[nodiscard]] inline size_t GetSize() const { return m_scripts.size(); }
+
+    /// Getter for the Lua state.
+    /// \return Lua state pointer.
+    [[nodiscard]] inline lua_State* GetState() const { return m_state; }
+
+private:
+    /// Registered script file.
+    struct Script {
+        std::string name;
+        std::string path;
+        /// Indexes of scripts it depends on, always registered earlier.
+        std::vector<size_t> dependencies{};
+        /// Module table, environment of script.
+        Object module{};
+    };
+
+    /// Creates module table falling back to globals and publishes it under name.
+    Object createModule(const std::string& name) const {
+        lua_newtable(m_state);
+        lua_createtable(m_state, 0, 1);
+        lua_rawgeti(m_state, LUA_REGISTRYINDEX, LUA_RIDX_GLOBALS);
+        lua_setfield(m_state, -2, "__index");
+        lua_setmetatable(m_state, -2);
+        lua_pushvalue(m_state, -1);
+        lua_setglobal(m_state, name.c_str());
+        luaL_getsubtable(m_state, LUA_REGISTRYINDEX, LUA_LOADED_TABLE);
+        lua_pushvalue(m_state, -2);
+        lua_setfield(m_state, -2, name.c_str());
+        lua_pop(m_state, 1);
+        return Object::CreateAndPop(m_state);
+    }
+
+    /// Runs script into its module table. Fields of a table returned by script are copied to module, so identity of module is kept.
+    bool run(const Script& script) {
+        const Chunk* chunk = m_chunks.GetFile(script.path.c_str());
+        if (chunk == nullptr) {
+            return false;
+        }
+        chunk->Reference::Push(m_state);
+        script.module.Push();
+        lua_setupvalue(m_state, -2, 1);  // Main chunks always have _ENV as first upvalue
+        if (lua_pcall(m_state, 0, 1, 0) != LUA_OK) {
+            const char* msg = lua_tostring(m_state, -1);
+            std::string error{"Running script " + script.name + " failed: " + (msg != nullptr ? msg : "(error object is not a string)")};
+            lua_pop(m_state, 1);
+            return Stack::DefaultReturnWithError<bool>(std::move(error));
+        }
+        if (lua_istable(m_state, -1)) {
+            script.module.Push();
+            if (!lua_rawequal(m_state, -1, -2)) {
+                lua_pushnil(m_state);
+                while (lua_next(m_state, -3) != 0) {
+                    lua_pushvalue(m_state, -2);
+                    lua_insert(m_state, -2);
+                    lua_rawset(m_state, -4);
+                }
+            }
+            lua_pop(m_state, 1);
+        }
+        lua_pop(m_state, 1);
+        return true;
+    }
+
+    /// Lua state.
+    lua_State* m_state{nullptr};
+    /// Compiled chunks of scripts.
+    ChunkCache m_chunks;
+    /// Scripts in registration order.
+    std::vector<Script> m_scripts;
+    /// Indexes of scripts by name.
+    std::unordered_map<std::string, size_t> m_names;
+};
+}  // namespace moon
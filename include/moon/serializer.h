@@ -0,0 +1,381 @@
+#pragma once
+
+#include "object.h"
+
+namespace moon {
+/// Compact binary encoding of Lua values, for shipping script state between processes or checkpointing it. Integers and floats are kept
+/// apart, strings are copied as raw bytes and tables keep their array part apart from their hash part. Tables reached more than once,
+/// including cycles, are encoded once and referenced afterwards, so shared structure is preserved. Tags follow MessagePack where types
+/// overlap. Multi byte values are stored in host byte order, so buffers are portable between processes of the same architecture.
+/// Functions, userdata and threads can not be encoded, and metatables are not kept.
+class Serializer {
+public:
+    /// Deepest table nesting encoded or decoded, which bounds recursion.
+    static constexpr int s_maxDepth{200};
+
+    /// Encodes value at index, appending it to buffer. Buffer is left untouched on errors.
+    /// \param L Lua state.
+    /// \param index Index of value in stack.
+    /// \param buffer Buffer to append to.
+    /// \return Whether or not value was encoded.
+    static bool Encode(lua_State* L, int index, std::vector<uint8_t>& buffer) {
+        index = lua_absindex(L, index);
+        int top = lua_gettop(L);
+        size_t size = buffer.size();
+        lua_newtable(L);  // Tables already encoded, to their id
+        Encoder encoder{L, buffer, lua_gettop(L)};
+        bool encoded = encoder.Value(index, 0);
+        lua_settop(L, top);
+        if (!encoded) {
+            buffer.resize(size);
+            return Stack::DefaultReturnWithError<bool>(std::move(encoder.error));
+        }
+        return true;
+    }
+
+    /// Encodes value referenced by object, appending it to buffer. Buffer is left untouched on errors.
+    /// \param object Object to encode.
+    /// \param buffer Buffer to append to.
+    /// \return Whether or not value was encoded.
+    static bool Encode(const Object& object, std::vector<uint8_t>& buffer) {
+        if (!object.IsLoaded()) {
+            return Stack::DefaultReturnWithError<bool>("tried to encode an Object not loaded");
+        }
+        object.Push();
+        Stack::PopGuard guard{object.GetState()};
+        return Encode(object.GetState(), -1, buffer);
+    }
+
+    /// Decodes a single value and pushes it to stack. Nothing is pushed on errors, e.g. truncated or malformed data.
+    /// \param L Lua state.
+    /// \param data Encoded data.
+    /// \param size Size of data.
+    /// \return Number of bytes read, 0 on errors.
+    static size_t Decode(lua_State* L, const uint8_t* data, size_t size) {
+        int top = lua_gettop(L);
+        lua_newtable(L);  // Tables already decoded, by id
+        Decoder decoder{L, data, size, lua_gettop(L)};
+        if (!decoder.Value(0)) {
+            lua_settop(L, top);
+            Logger::Error(decoder.error);
+            return 0;
+        }
+        lua_remove(L, -2);
+        return decoder.position;
+    }
+
+    /// Decodes a single value as an object.
+    /// \param L Lua state.
+    /// \param buffer Encoded data.
+    /// \return Object referencing decoded value, not loaded on errors.
+    static Object Decode(lua_State* L, const std::vector<uint8_t>& buffer) {
+        if (Decode(L, buffer.data(), buffer.size()) == 0) {
+            return Object{};
+        }
+        return Object::CreateAndPop(L);
+    }
+
+private:
+    enum Tag : uint8_t {
+        PositiveFixInt = 0x00,  // 0x00 - 0x7f
+        FixString = 0xa0,       // 0xa0 - 0xbf
+        Nil = 0xc0,
+        TableReference = 0xc1,
+        False = 0xc2,
+        True = 0xc3,
+        Float64 = 0xcb,
+        Int8 = 0xd0,
+        Int16 = 0xd1,
+        Int32 = 0xd2,
+        Int64 = 0xd3,
+        String8 = 0xd9,
+        String32 = 0xdb,
+        Table = 0xde,
+        NegativeFixInt = 0xe0  // 0xe0 - 0xff
+    };
+
+    struct Encoder {
+        lua_State* L;
+        std::vector<uint8_t>& out;
+        /// Index of table mapping encoded tables to their id.
+        int refs;
+        /// Number of tables encoded.
+        uint32_t tables{0};
+        /// Error message, only built on errors.
+        std::string error{};
+
+        template <typename T>
+        inline void Put(uint8_t tag, T value) {
+            out.push_back(tag);
+            auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+            out.insert(out.end(), bytes, bytes + sizeof(T));
+        }
+
+        void Integer(lua_Integer value) {
+            if (value >= 0 && value <= 0x7f) {
+                out.push_back((uint8_t)value);
+            } else if (value < 0 && value >= -32) {
+                out.push_back((uint8_t)(NegativeFixInt | (value + 32)));
+            } else if (value >= INT8_MIN && value <= INT8_MAX) {
+                Put(Int8, (int8_t)value);
+            } else if (value >= INT16_MIN && value <= INT16_MAX) {
+                Put(Int16, (int16_t)value);
+            } else if (value >= INT32_MIN && value <= INT32_MAX) {
+                Put(Int32, (int32_t)value);
+            } else {
+                Put(Int64, (int64_t)value);
+            }
+        }
+
+        bool String(int index) {
+            size_t size;
+            const char* data = lua_tolstring(L, index, &size);
+            if (size < 32) {
+                out.push_back((uint8_t)(FixString | size));
+            } else if (size <= UINT8_MAX) {
+                Put(String8, (uint8_t)size);
+            } else if (size <= UINT32_MAX) {
+                Put(String32, (uint32_t)size);
+            } else {
+                error = "string too large to encode";
+                return false;
+            }
+            out.insert(out.end(), data, data + size);
+            return true;
+        }
+
+        /// Writes array length and hash size at offset, once known.
+        void Patch(size_t offset, uint32_t array, uint32_t hash) {
+            std::memcpy(out.data() + offset, &array, sizeof(uint32_t));
+            std::memcpy(out.data() + offset + sizeof(uint32_t), &hash, sizeof(uint32_t));
+        }
+
+        bool TableValue(int index, int depth) {
+            if (depth >= s_maxDepth) {
+                error = "tables nested too deep to encode";
+                return false;
+            }
+            if (!lua_checkstack(L, 4)) {
+                error = "not enough stack space to encode table";
+                return false;
+            }
+            lua_pushvalue(L, index);
+            if (lua_rawget(L, refs) == LUA_TNUMBER) {
+                Put(TableReference, (uint32_t)lua_tointeger(L, -1));
+                lua_pop(L, 1);
+                return true;
+            }
+            lua_pop(L, 1);
+            lua_pushvalue(L, index);
+            lua_pushinteger(L, ++tables);
+            lua_rawset(L, refs);
+
+            out.push_back(Table);
+            size_t header = out.size();
+            out.resize(header + 2 * sizeof(uint32_t));
+            uint32_t array = 0;
+            while (lua_rawgeti(L, index, (lua_Integer)array + 1) != LUA_TNIL) {
+                if (!Value(lua_gettop(L), depth + 1)) {
+                    return false;
+                }
+                lua_pop(L, 1);
+                ++array;
+            }
+            lua_pop(L, 1);
+            uint32_t hash = 0;
+            lua_pushnil(L);
+            while (lua_next(L, index) != 0) {
+                if (lua_isinteger(L, -2)) {
+                    lua_Integer key = lua_tointeger(L, -2);
+                    if (key >= 1 && key <= (lua_Integer)array) {
+                        lua_pop(L, 1);
+                        continue;
+                    }
+                }
+                if (!Value(lua_gettop(L) - 1, depth + 1) || !Value(lua_gettop(L), depth + 1)) {
+                    return false;
+                }
+                lua_pop(L, 1);
+                ++hash;
+            }
+            Patch(header, array, hash);
+            return true;
+        }
+
+        bool Value(int index, int depth) {
+            switch (lua_type(L, index)) {
+                case LUA_TNIL:
+                    out.push_back(Nil);
+                    return true;
+                case LUA_TBOOLEAN:
+                    out.push_back(lua_toboolean(L, index) ? True : False);
+                    return true;
+                case LUA_TNUMBER:
+                    if (lua_isinteger(L, index)) {
+                        Integer(lua_tointeger(L, index));
+                    } else {
+                        Put(Float64, (double)lua_tonumber(L, index));
+                    }
+                    return true;
+                case LUA_TSTRING:
+                    return String(index);
+                case LUA_TTABLE:
+                    return TableValue(index, depth);
+                default:
+                    error = std::string("can not encode value of type ") + lua_typename(L, lua_type(L, index));
+                    return false;
+            }
+        }
+    };
+
+    struct Decoder {
+        lua_State* L;
+        const uint8_t* data;
+        size_t size;
+        /// Index of table holding decoded tables by id.
+        int refs;
+        /// Number of bytes read.
+        size_t position{0};
+        /// Number of tables decoded.
+        uint32_t tables{0};
+        /// Error message, only built on errors.
+        std::string error{};
+
+        template <typename T>
+        inline bool Read(T& value) {
+            if (size - position < sizeof(T)) {
+                error = "truncated data when decoding";
+                return false;
+            }
+            std::memcpy(&value, data + position, sizeof(T));
+            position += sizeof(T);
+            return true;
+        }
+
+        template <typename T>
+        inline bool Integer() {
+            T value;
+            if (!Read(value)) {
+                return false;
+            }
+            lua_pushinteger(L, (lua_Integer)value);
+            return true;
+        }
+
+        bool String(size_t length) {
+            if (size - position < length) {
+                error = "truncated string when decoding";
+                return false;
+            }
+            lua_pushlstring(L, reinterpret_cast<const char*>(data + position), length);
+            position += length;
+            return true;
+        }
+
+        bool TableValue(int depth) {
+            uint32_t array;
+            uint32_t hash;
+            if (!Read(array) || !Read(hash)) {
+                return false;
+            }
+            // Every value takes at least one byte, so sizes are bounded by remaining data before anything is allocated
+            if (depth >= s_maxDepth || (size_t)array + 2 * (size_t)hash > size - position || !lua_checkstack(L, 4)) {
+                error = "invalid table when decoding";
+                return false;
+            }
+            lua_createtable(L, (int)array, (int)hash);
+            int table = lua_gettop(L);
+            lua_pushvalue(L, table);
+            lua_rawseti(L, refs, ++tables);
+            for (uint32_t i = 1; i <= array; ++i) {
+                if (!Value(depth + 1)) {
+                    return false;
+                }
+                lua_rawseti(L, table, i);
+            }
+            for (uint32_t i = 0; i < hash; ++i) {
+                if (!Value(depth + 1)) {
+                    return false;
+                }
+                if (lua_isnil(L, -1) || (lua_type(L, -1) == LUA_TNUMBER && lua_tonumber(L, -1) != lua_tonumber(L, -1))) {
+                    error = "invalid table key when decoding";
+                    return false;
+                }
+                if (!Value(depth + 1)) {
+                    return false;
+                }
+                lua_rawset(L, table);
+            }
+            return true;
+        }
+
+        bool Value(int depth) {
+            uint8_t tag;
+            if (!Read(tag)) {
+                return false;
+            }
+            if (tag <= 0x7f) {
+                lua_pushinteger(L, tag);
+                return true;
+            }
+            if (tag >= NegativeFixInt) {
+                lua_pushinteger(L, (lua_Integer)tag - 0x100);
+                return true;
+            }
+            if (tag >= FixString && tag <= FixString + 31) {
+                return String(tag - FixString);
+            }
+            switch (tag) {
+                case Nil:
+                    lua_pushnil(L);
+                    return true;
+                case False:
+                case True:
+                    lua_pushboolean(L, tag == True);
+                    return true;
+                case Float64: {
+                    double value;
+                    if (!Read(value)) {
+                        return false;
+                    }
+                    lua_pushnumber(L, (lua_Number)value);
+                    return true;
+                }
+                case Int8:
+                    return Integer<int8_t>();
+                case Int16:
+                    return Integer<int16_t>();
+                case Int32:
+                    return Integer<int32_t>();
+                case Int64:
+                    return Integer<int64_t>();
+                case String8: {
+                    uint8_t length;
+                    return Read(length) && String(length);
+                }
+                case String32: {
+                    uint32_t length;
+                    return Read(length) && String(length);
+                }
+                case Table:
+                    return TableValue(depth);
+                case TableReference: {
+                    uint32_t id;
+                    if (!Read(id)) {
+                        return false;
+                    }
+                    if (id == 0 || id > tables) {
+                        error = "invalid table reference when decoding";
+                        return false;
+                    }
+                    lua_rawgeti(L, refs, id);
+                    return true;
+                }
+                default:
+                    error = "unknown tag when decoding";
+                    return false;
+            }
+        }
+    };
+};
+}  // namespace moon
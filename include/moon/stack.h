@@ -1,9 +1,10 @@
 #pragma once
 
+#include "key.h"
 #include "logger.h"
+#include "profiler.h"
 #include "reference.h"
 #include "traits.h"
-#include "usertype.h"
 
 namespace moon {
 template <typename T>
@@ -65,7 +66,7 @@ public:
     }
 
     template <typename R>
-    static meta::is_string_t<R, bool> CheckValue(lua_State* L, int index) {
+    static meta::is_sized_string_t<R, bool> CheckValue(lua_State* L, int index) {
         return lua_isstring(L, index);
     }
 
@@ -89,6 +90,11 @@ public:
         return lua_istable(L, index);
     }
 
+    template <typename R>
+    static meta::is_array_t<R, bool> CheckValue(lua_State* L, int index) {
+        return lua_istable(L, index);
+    }
+
     template <typename R>
     static meta::is_map_t<R, bool> CheckValue(lua_State* L, int index) {
         return lua_istable(L, index);
@@ -99,6 +105,11 @@ public:
         return lua_isfunction(L, index);
     }
 
+    template <typename R>
+    static meta::is_described_t<R, bool> CheckValue(lua_State* L, int index) {
+        return lua_istable(L, index);
+    }
+
     template <typename R>
     static meta::is_bool_t<R> GetValue(lua_State* L, int index) {
         if (!CheckValue<R>(L, index)) {
@@ -123,8 +134,9 @@ public:
         return static_cast<R>(lua_tonumber(L, index));
     }
 
+    /// String views point to Lua owned memory, valid only while the string is referenced in Lua, e.g. during a function call.
     template <typename R>
-    static meta::is_string_t<R> GetValue(lua_State* L, int index) {
+    static meta::is_sized_string_t<R> GetValue(lua_State* L, int index) {
         if (!CheckValue<R>(L, index)) {
             return DefaultReturnWithError<R>("type check failed: string");
         }
@@ -172,18 +184,26 @@ public:
         R vec;
         vec.reserve(size);
         for (size_t i = 1; i <= size; ++i) {
-            lua_pushinteger(L, i);
-            lua_gettable(L, index);
-            if (lua_type(L, -1) == LUA_TNIL) {
+            if (lua_rawgeti(L, index, (lua_Integer)i) == LUA_TNIL) {
                 lua_pop(L, 1);
                 break;
             }
-            vec.emplace_back(std::move(GetValue<typename R::value_type>(L, lua_gettop(L))));
+            vec.emplace_back(GetValue<typename R::value_type>(L, -1));
             lua_pop(L, 1);
         }
         return vec;
     }
 
+    template <typename R>
+    static meta::is_array_t<R> GetValue(lua_State* L, int index) {
+        if (!CheckValue<R>(L, index)) {
+            return DefaultReturnWithError<R>("type check failed: table");
+        }
+        R array{};
+        GetArray(L, index, array.data(), array.size());
+        return array;
+    }
+
     template <typename R>
     static meta::is_map_t<R> GetValue(lua_State* L, int index) {
         if (!CheckValue<R>(L, index)) {
@@ -193,7 +213,7 @@ public:
         lua_pushnil(L);
         R map;
         while (lua_next(L, index) != 0) {
-            map.emplace(std::move(GetValue<std::string>(L, -2)), std::move(GetValue<typename R::mapped_type>(L, lua_gettop(L))));
+            map.emplace(GetValue<typename R::key_type>(L, -2), GetValue<typename R::mapped_type>(L, -1));
             lua_pop(L, 1);
         }
         return map;
@@ -207,6 +227,18 @@ public:
         return STLFunctionSpread<R>::GetFunctor(L, index);
     }
 
+    /// Fields missing in table keep their default value.
+    template <typename R>
+    static meta::is_described_t<R> GetValue(lua_State* L, int index) {
+        if (!CheckValue<R>(L, index)) {
+            return DefaultReturnWithError<R>("type check failed: table");
+        }
+        index = lua_absindex(L, index);
+        R value{};
+        std::apply([&](const auto&... fields) { (getMember(L, index, value, fields), ...); }, Fields<R>::value);
+        return value;
+    }
+
     template <typename R>
     static meta::is_tuple_t<R> GetValue(lua_State* L, int index) {
         index = lua_absindex(L, index);
@@ -219,6 +251,61 @@ public:
         return getTupleHelper<R>(std::make_index_sequence<elements>{}, L, starting);
     }
 
+    /// Gets value at index as C type, checking and converting it at once. Nothing is logged nor allocated on failure. Numbers follow
+    /// Lua conversion rules, so integral floats and numeric strings are read as integers, and integers as floating points.
+    /// \tparam R C type. Tuples are not supported.
+    /// \param L Lua state.
+    /// \param index Index of value in stack.
+    /// \return Value or reason it could not be read.
+    template <typename R>
+    static Expected<R> TryGetValue(lua_State* L, int index) {
+        static_assert(!meta::is_tuple_v<R>, "tuples can not be read with TryGetValue");
+        if constexpr (meta::is_integral_v<R>) {
+            int isnum = 0;
+            lua_Integer value = lua_tointegerx(L, index, &isnum);
+            if (isnum == 0) {
+                return failure(L, index);
+            }
+            if (!fits<R>(value)) {
+                return ValueError::OutOfRange;
+            }
+            return static_cast<R>(value);
+        } else if constexpr (std::is_floating_point_v<R>) {
+            int isnum = 0;
+            lua_Number value = lua_tonumberx(L, index, &isnum);
+            if (isnum == 0) {
+                return failure(L, index);
+            }
+            return static_cast<R>(value);
+        } else if constexpr (meta::is_bool_v<R>) {
+            if (lua_type(L, index) != LUA_TBOOLEAN) {
+                return failure(L, index);
+            }
+            return lua_toboolean(L, index) != 0;
+        } else if constexpr (meta::is_sized_string_v<R> || meta::is_c_string_v<R>) {
+            size_t size;
+            const char* buffer = lua_tolstring(L, index, &size);
+            if (buffer == nullptr) {
+                return failure(L, index);
+            }
+            if constexpr (meta::is_c_string_v<R>) {
+                return buffer;
+            } else {
+                return R{buffer, size};
+            }
+        } else if constexpr (meta::is_moon_reference_v<R>) {
+            if (lua_isnone(L, index)) {
+                return ValueError::Missing;
+            }
+            return GetValue<R>(L, index);
+        } else {
+            if (!CheckValue<R>(L, index)) {
+                return failure(L, index);
+            }
+            return GetValue<R>(L, index);
+        }
+    }
+
     template <typename T>
     static meta::is_bool_t<T, void> PushValue(lua_State* L, T&& value) {
         lua_pushboolean(L, value);
@@ -235,8 +322,8 @@ public:
     }
 
     template <typename T>
-    static meta::is_string_t<T, void> PushValue(lua_State* L, T&& value) {
-        lua_pushstring(L, value.c_str());
+    static meta::is_sized_string_t<T, void> PushValue(lua_State* L, T&& value) {
+        lua_pushlstring(L, value.data(), value.size());
     }
 
     template <typename T>
@@ -246,32 +333,49 @@ public:
 
     template <typename T>
     static meta::is_vector_t<T, void> PushValue(lua_State* L, T&& value) {
-        lua_newtable(L);
-        unsigned index = 1;
-        for (auto element : value) {
-            PushValue(L, std::forward<unsigned>(index));
-            PushValue(L, std::forward<decltype(element)>(element));
-            lua_settable(L, -3);
-            ++index;
-        }
+        pushSequence(L, std::as_const(value));
+    }
+
+    template <typename T>
+    static meta::is_array_t<T, void> PushValue(lua_State* L, T&& value) {
+        pushSequence(L, std::as_const(value));
     }
 
     template <typename T>
     static meta::is_map_t<T, void> PushValue(lua_State* L, T&& value) {
-        lua_newtable(L);
-        for (auto element : value) {
-            PushValue(L, std::forward<decltype(element.first)>(element.first));
-            PushValue(L, std::forward<decltype(element.second)>(element.second));
-            lua_settable(L, -3);
+        lua_createtable(L, 0, (int)value.size());
+        for (const auto& [key, element] : std::as_const(value)) {
+            PushValue(L, key);
+            PushValue(L, element);
+            lua_rawset(L, -3);
         }
     }
 
+    template <typename T>
+    static meta::is_described_t<T, void> PushValue(lua_State* L, T&& value) {
+        const auto& fields = Fields<std::decay_t<T>>::value;
+        lua_createtable(L, 0, (int)std::tuple_size_v<std::decay_t<decltype(fields)>>);
+        std::apply([&](const auto&... field) { ((PushValue(L, value.*field.member), lua_setfield(L, -2, field.name)), ...); }, fields);
+    }
+
     template <typename T>
     static meta::is_binding_t<T, void> PushValue(lua_State* L, T* value) {
-        auto** a = static_cast<T**>(lua_newuserdata(L, sizeof(T*)));  // Create userdata
-        *a = value;
-        luaL_getmetatable(L, T::Binding.GetName());
-        lua_setmetatable(L, -2);
+        LuaClass<T>::Push(L, value);
+    }
+
+    template <typename T>
+    static meta::is_binding_t<T, void> PushValue(lua_State* L, const Borrowed<T>& value) {
+        LuaClass<T>::Push(L, value);
+    }
+
+    template <typename T>
+    static meta::is_binding_t<T, void> PushValue(lua_State* L, const Owned<T>& value) {
+        LuaClass<T>::Push(L, value);
+    }
+
+    template <typename T>
+    static meta::is_binding_t<T, void> PushValue(lua_State* L, std::shared_ptr<T> value) {
+        LuaClass<T>::Push(L, std::move(value));
     }
 
     template <typename T>
@@ -281,6 +385,45 @@ public:
 
     static void PushValue(lua_State* L, void* value) { lua_pushlightuserdata(L, value); }
 
+    /// Pushes contiguous buffer as a new presized array table.
+    /// \tparam T Element type.
+    /// \param L Lua state.
+    /// \param data First element.
+    /// \param size Number of elements.
+    template <typename T>
+    static void PushArray(lua_State* L, const T* data, size_t size) {
+        lua_createtable(L, (int)size, 0);
+        for (size_t i = 0; i < size; ++i) {
+            PushValue(L, data[i]);
+            lua_rawseti(L, -2, (lua_Integer)i + 1);
+        }
+    }
+
+    /// Reads array table elements into contiguous buffer, stopping at first nil or when buffer is full.
+    /// \tparam T Element type.
+    /// \param L Lua state.
+    /// \param index Index of table in stack.
+    /// \param data Buffer to write to.
+    /// \param size Buffer capacity.
+    /// \return Number of elements read.
+    template <typename T>
+    static size_t GetArray(lua_State* L, int index, T* data, size_t size) {
+        if (!lua_istable(L, index)) {
+            return DefaultReturnWithError<size_t>("type check failed: table");
+        }
+        index = lua_absindex(L, index);
+        size = std::min(size, (size_t)lua_rawlen(L, index));
+        for (size_t i = 0; i < size; ++i) {
+            if (lua_rawgeti(L, index, (lua_Integer)i + 1) == LUA_TNIL) {
+                lua_pop(L, 1);
+                return i;
+            }
+            data[i] = GetValue<T>(L, -1);
+            lua_pop(L, 1);
+        }
+        return size;
+    }
+
     static void PushValue(lua_State* L, const Reference& value) { value.Push(L); }  // Needs to be const ref, for now, to handle Object
 
     template <typename Key>
@@ -293,11 +436,33 @@ public:
     }
 
     template <typename Key>
-    static meta::is_basic_string_t<Key, bool> PushField(lua_State* L, int index, Key&& key) {
+    static meta::is_c_string_t<Key, bool> PushField(lua_State* L, int index, Key&& key) {
+        if (lua_isnil(L, index) || !lua_istable(L, index)) {
+            return DefaultReturnWithError<bool>("tried to push field in a null table or not a table");
+        }
+        lua_getfield(L, index, key);
+        return true;
+    }
+
+    template <typename Key>
+    static meta::is_sized_string_t<Key, bool> PushField(lua_State* L, int index, Key&& key) {
         if (lua_isnil(L, index) || !lua_istable(L, index)) {
             return DefaultReturnWithError<bool>("tried to push field in a null table or not a table");
         }
-        lua_getfield(L, index, &key[0]);
+        index = lua_absindex(L, index);
+        lua_pushlstring(L, key.data(), key.size());
+        lua_gettable(L, index);
+        return true;
+    }
+
+    template <typename Key>
+    static meta::is_interned_key_t<Key, bool> PushField(lua_State* L, int index, Key&& key) {
+        if (!lua_istable(L, index)) {
+            return DefaultReturnWithError<bool>("tried to push field in a null table or not a table");
+        }
+        index = lua_absindex(L, index);
+        key.Push(L);
+        lua_rawget(L, index);
         return true;
     }
 
@@ -311,19 +476,126 @@ public:
     }
 
     template <typename Key>
-    static meta::is_basic_string_t<Key, bool> SetField(lua_State* L, int index, Key&& key) {
+    static meta::is_c_string_t<Key, bool> SetField(lua_State* L, int index, Key&& key) {
         if (lua_isnil(L, index) || !lua_istable(L, index)) {
             return DefaultReturnWithError<bool>("tried to set field in a null table or not a table");
         }
-        lua_setfield(L, index, &key[0]);
+        lua_setfield(L, index, key);
         return true;
     }
 
+    template <typename Key>
+    static meta::is_sized_string_t<Key, bool> SetField(lua_State* L, int index, Key&& key) {
+        if (lua_isnil(L, index) || !lua_istable(L, index)) {
+            return DefaultReturnWithError<bool>("tried to set field in a null table or not a table");
+        }
+        index = lua_absindex(L, index);
+        lua_pushlstring(L, key.data(), key.size());
+        lua_insert(L, -2);
+        lua_settable(L, index);
+        return true;
+    }
+
+    template <typename Key>
+    static meta::is_interned_key_t<Key, bool> SetField(lua_State* L, int index, Key&& key) {
+        if (!lua_istable(L, index)) {
+            return DefaultReturnWithError<bool>("tried to set field in a null table or not a table");
+        }
+        index = lua_absindex(L, index);
+        key.Push(L);
+        lua_insert(L, -2);
+        lua_rawset(L, index);
+        return true;
+    }
+
+    template <typename Key>
+    static meta::is_c_string_t<Key, void> PushGlobal(lua_State* L, Key&& key) {
+        lua_getglobal(L, key);
+    }
+
+    template <typename Key>
+    static meta::is_sized_string_t<Key, void> PushGlobal(lua_State* L, Key&& key) {
+        lua_pushglobaltable(L);
+        PushField(L, -1, std::forward<Key>(key));
+        lua_remove(L, -2);
+    }
+
+    template <typename Key>
+    static meta::is_interned_key_t<Key, void> PushGlobal(lua_State* L, Key&& key) {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_GLOBALS);
+        key.Push(L);
+        lua_rawget(L, -2);
+        lua_remove(L, -2);
+    }
+
+    /// Sets global with value at top of stack, which is popped.
+    template <typename Key>
+    static meta::is_c_string_t<Key, void> SetGlobal(lua_State* L, Key&& key) {
+        lua_setglobal(L, key);
+    }
+
+    template <typename Key>
+    static meta::is_sized_string_t<Key, void> SetGlobal(lua_State* L, Key&& key) {
+        lua_pushglobaltable(L);
+        lua_insert(L, -2);
+        SetField(L, -2, std::forward<Key>(key));
+        lua_pop(L, 1);
+    }
+
+    template <typename Key>
+    static meta::is_interned_key_t<Key, void> SetGlobal(lua_State* L, Key&& key) {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_GLOBALS);
+        lua_insert(L, -2);
+        SetField(L, -2, std::forward<Key>(key));
+        lua_pop(L, 1);
+    }
+
     static std::optional<std::string> CallFunctionWithErrorCheck(lua_State* L, int numberArgs, int numberReturns) {
         return checkErrorStatus(L, lua_pcall(L, numberArgs, numberReturns, 0));
     }
 
 private:
+    /// Reason value at index could not be read.
+    static inline ValueError failure(lua_State* L, int index) {
+        return lua_isnoneornil(L, index) ? ValueError::Missing : ValueError::TypeMismatch;
+    }
+
+    /// Checks if Lua integer fits in integral type.
+    template <typename R>
+    static constexpr bool fits(lua_Integer value) {
+        using limits = std::numeric_limits<R>;
+        if constexpr (std::is_unsigned_v<R>) {
+            return value >= 0 && (std::make_unsigned_t<lua_Integer>)value <= limits::max();
+        } else if constexpr (sizeof(R) < sizeof(lua_Integer)) {
+            return value >= limits::min() && value <= limits::max();
+        } else {
+            return true;
+        }
+    }
+
+    /// Reads field of described struct from table at index, keeping default value if nil.
+    template <typename T, typename U>
+    static void getMember(lua_State* L, int index, T& object, const Field<T, U>& field) {
+        if (lua_getfield(L, index, field.name) != LUA_TNIL) {
+            object.*field.member = GetValue<std::decay_t<U>>(L, -1);
+        }
+        lua_pop(L, 1);
+    }
+
+    /// Pushes sequence container as a new presized array table.
+    /// \tparam T Container type.
+    /// \param L Lua state.
+    /// \param value Container to push.
+    template <typename T>
+    static void pushSequence(lua_State* L, const T& value) {
+        lua_createtable(L, (int)value.size(), 0);
+        lua_Integer index = 1;
+        for (const auto& element : value) {
+            PushValue(L, element);
+            lua_rawseti(L, -2, index++);
+        }
+    }
+
     /// Tuple index based expander helper method.
     /// \tparam T Tuple type.
     /// \tparam indices Each of the tuple indices.
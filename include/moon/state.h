@@ -0,0 +1,549 @@
+#pragma once
+
+#include "allocator.h"
+#include "callback.h"
+#include "channel.h"
+#include "coroutine.h"
+#include "gc.h"
+#include "sandbox.h"
+#include "scriptregistry.h"
+#include "serializer.h"
+#include "stateview.h"
+#include "tableview.h"
+#include "transfer.h"
+
+namespace moon {
+/// Owns an independent Lua state and exposes the whole Moon API on top of it. Multiple states can coexist, e.g. one per worker thread,
+/// since nothing here relies on static storage. A state is movable but not copyable.
+class State {
+public:
+    /// Creates a new Lua state, opens libs and initializes helper classes.
+    State() : State(std::unique_ptr<Allocator>{}) {}
+
+    /// Creates a new Lua state using provided allocator for all its memory, opens libs and initializes helper classes.
+    /// \param allocator Allocator owned by this state. Default Lua allocator is used if null.
+    explicit State(std::unique_ptr<Allocator> allocator) : State(std::move(allocator), Sandbox::All) {}
+
+    /// Creates a new Lua state opening only selected standard libraries, e.g. Sandbox::Safe for untrusted scripts.
+    /// \param allocator Allocator owned by this state. Default Lua allocator is used if null.
+    /// \param libraries Flags of libraries to open, from Sandbox::Libraries.
+    State(std::unique_ptr<Allocator> allocator, unsigned libraries)
+        : m_allocator(std::move(allocator)),
+          m_state(m_allocator ? lua_newstate(&Allocator::Allocate, m_allocator.get()) : luaL_newstate()),
+          m_view(m_state),
+          m_chunks(m_state) {
+        lua_atpanic(m_state, &State::panic);
+        Sandbox::OpenLibraries(m_state, libraries);
+        Invokable::Register(m_state);
+        GarbageCollector::Register(m_state);
+    }
+
+    State(const State&) = delete;
+
+    State(State&& other) noexcept
+        : m_allocator(std::move(other.m_allocator)), m_state(other.m_state), m_view(m_state), m_chunks(std::move(other.m_chunks)),
+          m_callStats(std::move(other.m_callStats)) {
+        other.m_state = nullptr;
+        other.m_view = StateView{};
+    }
+
+    ~State() { Close(); }
+
+    State& operator=(const State&) = delete;
+
+    State& operator=(State&& other) noexcept {
+        if (&other == this) {
+            return *this;
+        }
+        Close();
+        m_allocator = std::move(other.m_allocator);
+        m_state = other.m_state;
+        m_view = StateView{m_state};
+        m_chunks = std::move(other.m_chunks);
+        m_callStats = std::move(other.m_callStats);
+        other.m_state = nullptr;
+        other.m_view = StateView{};
+        return *this;
+    }
+
+    /// Closes Lua state. Safe to call multiple times.
+    void Close() {
+        if (m_state == nullptr) {
+            return;
+        }
+        m_chunks.Clear();
+        lua_close(m_state);
+        m_state = nullptr;
+        m_view = StateView{};
+    }
+
+    /// Getter for Lua state/stack.
+    /// \return Lua state pointer.
+    [[nodiscard]] inline lua_State* GetState() const { return m_state; }
+
+    /// Getter for custom allocator of this state.
+    /// \return Allocator, null if default Lua allocator is used.
+    [[nodiscard]] inline Allocator* GetAllocator() const { return m_allocator.get(); }
+
+    /// Getter for garbage collector controls.
+    /// \return Garbage collector of this state.
+    [[nodiscard]] inline GarbageCollector GC() const { return GarbageCollector{m_state}; }
+
+    /// Encodes value at index in stack as binary, appending it to buffer. See moon::Serializer.
+    /// \param index Index of value in stack.
+    /// \param buffer Buffer to append to.
+    /// \return Whether or not value was encoded.
+    inline bool Encode(int index, std::vector<uint8_t>& buffer) const { return Serializer::Encode(m_state, index, buffer); }
+
+    /// Decodes a value encoded as binary.
+    /// \param buffer Encoded data.
+    /// \return Object referencing decoded value, not loaded on errors.
+    [[nodiscard]] inline Object Decode(const std::vector<uint8_t>& buffer) const { return Serializer::Decode(m_state, buffer); }
+
+    /// Getter for top index in Lua stack.
+    /// \return Lua stack top index.
+    [[nodiscard]] inline int GetTop() const { return lua_gettop(m_state); }
+
+    /// Checks if provided index is valid within the range of current Lua stack.
+    /// \param index Index to check.
+    /// \return Whether or not index is valid.
+    [[nodiscard]] bool IsValidIndex(int index) const {
+        int top = GetTop();
+        if (index == 0 || index > top) {
+            return false;
+        }
+        if (index < 0) {
+            return IsValidIndex(top + index + 1);
+        }
+        return true;
+    }
+
+    /// Lua stack can be accessed with positive (up de stack) or negative (down the stack) indexes.
+    /// This method converts a negative index to a positive one. Returns original if already positive.
+    /// \param index Index to convert.
+    /// \return Newly converted index.
+    [[nodiscard]] inline int ConvertNegativeIndex(int index) const { return lua_absindex(m_state, index); }
+
+    /// Loads specified file script.
+    /// \param filePath File path to load.
+    /// \return Whether or not file was successfully loaded.
+    bool LoadFile(const char* filePath) const {
+        if (!checkStatus(luaL_loadfile(m_state, filePath), "Error loading file")) {
+            return false;
+        }
+        return checkStatus(lua_pcall(m_state, 0, LUA_MULTRET, 0), "Loading file failed");
+    }
+
+    /// Runs Lua code snippet.
+    /// \param code Code to run.
+    /// \return Whether or not code ran without errors.
+    bool RunCode(const char* code) const {
+        if (!checkStatus(luaL_loadstring(m_state, code), "Error running code")) {
+            return false;
+        }
+        return checkStatus(lua_pcall(m_state, 0, LUA_MULTRET, 0), "Running code failed");
+    }
+
+    /// Runs Lua code snippet with bounded instructions, time and memory. Memory caps need state to be created with an allocator.
+    /// \param code Code to run.
+    /// \param limits Resource limits.
+    /// \return Outcome of code.
+    SandboxStatus RunSandboxed(const char* code, const SandboxLimits& limits) const { return Sandbox{m_state, limits}.RunCode(code); }
+
+    /// Loads specified text file script with bounded instructions, time and memory.
+    /// \param filePath File path to load.
+    /// \param limits Resource limits.
+    /// \return Outcome of file.
+    SandboxStatus LoadSandboxedFile(const char* filePath, const SandboxLimits& limits) const {
+        return Sandbox{m_state, limits}.LoadFile(filePath);
+    }
+
+    /// Compiles Lua code snippet without running it. Returned chunk can be ran multiple times without parsing code again.
+    /// \param code Code to compile.
+    /// \return Compiled chunk. Not loaded on errors.
+    [[nodiscard]] inline Chunk CompileCode(const char* code) const { return Chunk::FromCode(m_state, code); }
+
+    /// Compiles file script, source or precompiled, without running it.
+    /// \param filePath File path to compile.
+    /// \return Compiled chunk. Not loaded on errors.
+    [[nodiscard]] inline Chunk CompileFile(const char* filePath) const { return Chunk::FromFile(m_state, filePath); }
+
+    /// Runs Lua code snippet, compiling it only the first time it is seen.
+    /// \param code Code to run.
+    /// \return Whether or not code ran without errors.
+    bool RunCachedCode(const char* code) {
+        const auto* chunk = m_chunks.GetCode(code);
+        return chunk != nullptr && chunk->Run();
+    }
+
+    /// Loads specified file script, compiling it only if not cached or if file was modified since.
+    /// \param filePath File path to load.
+    /// \return Whether or not file was successfully loaded.
+    bool LoadCachedFile(const char* filePath) {
+        const auto* chunk = m_chunks.GetFile(filePath);
+        return chunk != nullptr && chunk->Run();
+    }
+
+    /// Getter for compiled chunks cache, used by RunCachedCode and LoadCachedFile.
+    /// \return Chunk cache.
+    inline ChunkCache& GetChunkCache() { return m_chunks; }
+
+    /// Get type of Lua value at index in stack or with specific name.
+    /// \tparam Keys Type of key(s) (integer/string).
+    /// \param keys Key(s) to check type of. When multiple are provided, nested global search will be used.
+    /// \return Moon type of value.
+    template <typename... Keys>
+    inline LuaType GetType(Keys&&... keys) const {
+        return Core::GetType(m_state, std::forward<Keys>(keys)...);
+    }
+
+    /// Checks if Lua value in index/name can be interpreted as specified C type.
+    /// \tparam T C type to check.
+    /// \tparam Keys Type of key (integer/string).
+    /// \param keys Key to check. When multiple are provided, nested global search will be used.
+    /// \return Whether or not value can be interpreted at specific type.
+    template <typename T, typename... Keys>
+    inline bool Check(Keys&&... keys) const {
+        return Core::Check<T>(m_state, std::forward<Keys>(keys)...);
+    }
+
+    /// Cleans/nulls a variable, nested or not.
+    /// \tparam Keys Key type forwarding.
+    /// \param keys Nested (or not) keys path to arrive at variable to clean.
+    template <typename... Keys>
+    inline void Clean(Keys&&... keys) const {
+        Core::Clean(m_state, std::forward<Keys>(keys)...);
+    }
+
+    /// Gets element(s) at specified Lua stack index and/or global name as C object.
+    /// \tparam Rets C type(s) to cast Lua object to.
+    /// \tparam Keys Integral or string
+    /// \param keys Index or global name to get from Lua stack.
+    /// \return C object.
+    template <typename... Rets, typename... Keys>
+    inline decltype(auto) Get(Keys&&... keys) const {
+        return Core::Get<Rets...>(m_state, std::forward<Keys>(keys)...);
+    }
+
+    /// Gets a single nested (or global, if single key is provided) value from Lua global table.
+    /// \tparam Ret C type to cast Lua object to.
+    /// \tparam Keys Integral or string.
+    /// \param keys Path to arrive at variable.
+    /// \return C object.
+    template <typename Ret, typename... Keys>
+    inline decltype(auto) GetNested(Keys&&... keys) const {
+        return Core::GetNested<Ret>(m_state, std::forward<Keys>(keys)...);
+    }
+
+    /// Gets a single nested (or global, if single key is provided) value, checking and converting it at once. Failures are not logged,
+    /// so this is suited for hot loops and for values that may legitimately be missing.
+    /// \tparam Ret C type to cast Lua object to.
+    /// \tparam Keys Integral or string.
+    /// \param keys Path to arrive at variable.
+    /// \return Value or reason it could not be read.
+    template <typename Ret, typename... Keys>
+    inline Expected<std::decay_t<Ret>> TryGet(Keys&&... keys) const {
+        return Core::TryGet<Ret>(m_state, std::forward<Keys>(keys)...);
+    }
+
+    /// Sets one or multiple pairs name/value globals in Lua.
+    /// \tparam Pairs Pair(s) type(s).
+    /// \param pairs Name and value pair to set.
+    /// \example Set("first", 1, "second", true,...)
+    template <typename... Pairs>
+    inline void Set(Pairs&&... pairs) const {
+        Core::Set(m_state, std::forward<Pairs>(pairs)...);
+    }
+
+    /// Sets a nested (or global) variable value. New keys are also created in table.
+    /// \tparam Args Argument types.
+    /// \param args The last argument must be the value to set variable, the others, the path to the variable.
+    template <typename... Args>
+    inline void SetNested(Args&&... args) const {
+        Core::SetNested(m_state, std::forward<Args>(args)...);
+    }
+
+    /// Helper method to push multiple values directly to Lua stack.
+    /// \tparam Args Values types.
+    /// \param args Values to push to Lua stack.
+    template <typename... Args>
+    inline void Push(Args&&... args) const {
+        (Core::Push(m_state, std::forward<Args>(args)), ...);
+    }
+
+    /// Get, assign or call a global variable from Lua.
+    /// \tparam Key Type of key.
+    /// \param key Global variable name or stack index.
+    /// \return Lookup proxy with assignment, call and implicit cast enabled.
+    template <typename Key>
+    inline LookupProxy<StateView, Key> At(Key&& key) const {
+        return {&m_view, std::forward<Key>(key)};
+    }
+
+    /// Access/create global scope and nested variables/functions in tables, directly with stl style operators, like [] and ().
+    /// \return View of this state global scope. Invalidated if state is moved.
+    [[nodiscard]] inline const StateView& View() const { return m_view; }
+
+    /// Access/create global scope and nested variables/functions in tables, directly with stl style operators, like [] and ().
+    /// \return View of this state global scope. Invalidated if state is moved.
+    [[nodiscard]] inline StateView& View() { return m_view; }
+
+    /// Push a nil (null) value to Lua stack.
+    inline void PushNull() const { lua_pushnil(m_state); }
+
+    /// Pushes a new empty table/map to stack.
+    inline void PushTable() const { lua_newtable(m_state); }
+
+    /// Tries to pop specified number of elements from stack. Logs an error if top is reached not popping any more.
+    /// \param nrOfElements Number of elements to pop from Lua stack.
+    void Pop(int nrOfElements = 1) const {
+        while (nrOfElements > 0) {
+            if (GetTop() <= 0) {
+                Logger::Warning("tried to pop stack but was empty already");
+                break;
+            }
+            lua_pop(m_state, 1);
+            --nrOfElements;
+        }
+    }
+
+    /// Registers and exposes C++ class to Lua.
+    /// \tparam T Class to be registered.
+    /// \param nameSpace Class namespace.
+    template <class T>
+    inline void RegisterClass(const char* nameSpace = nullptr) const {
+        LuaClass<T>::Register(m_state, nameSpace);
+    }
+
+    /// Registers and exposes C++ function to Lua.
+    /// \tparam Name Name type forwarding.
+    /// \tparam Func Function type.
+    /// \param name Function name to register in Lua.
+    /// \param func Function to register.
+    template <typename Name, typename Func>
+    inline void RegisterFunction(Name&& name, Func&& func) const {
+        Core::PushFunction(m_state, std::forward<Func>(func));
+        Invokable::SetName(m_state, -1, name);
+        Core::FieldHandler<true, Name>{}.Set(m_state, -1, std::forward<Name>(name));
+    }
+
+    /// Registers and exposes a compile time known C++ function to Lua, as a plain C function without upvalues.
+    /// \tparam func Function pointer to register.
+    /// \tparam Name Name type forwarding.
+    /// \param name Function name to register in Lua.
+    template <auto func, typename Name>
+    inline void RegisterFunction(Name&& name) const {
+        Core::PushFunction<func>(m_state);
+        Invokable::SetName(m_state, -1, name);
+        Core::FieldHandler<true, Name>{}.Set(m_state, -1, std::forward<Name>(name));
+    }
+
+    /// Calls a global Lua function.
+    /// \tparam Ret Return types.
+    /// \tparam Key Name type forwarding.
+    /// \tparam Args Argument types.
+    /// \param key Global function name.
+    /// \param args Arguments to call function with.
+    /// \return Return value of function.
+    template <typename... Ret, typename Key, typename... Args>
+    inline decltype(auto) Call(Key&& key, Args&&... args) const {
+        Profiler::Scope scope{m_state, callStats(key)};
+        Core::FieldHandler<true, Key>{}.Get(m_state, 0, std::forward<Key>(key));
+        return Core::Call<Ret...>(m_state, std::forward<Args>(args)...);
+    }
+
+    /// Make moon object directly in Lua stack from C object. Stack is immediately popped, since the reference is stored.
+    /// \tparam T C object type.
+    /// \param value C object.
+    /// \return Newly created moon object.
+    template <typename T>
+    inline Object MakeObject(T&& value) const {
+        Core::Push(m_state, std::forward<T>(value));
+        return Object::CreateAndPop(m_state);
+    }
+
+    /// Creates and stores a new ref of element at provided index.
+    /// \param index Index of element to create ref. Defaults to top of stack.
+    /// \return A new moon Object.
+    [[nodiscard]] inline Object MakeObjectFromIndex(int index = -1) const { return {m_state, index}; }
+
+    /// Creates a handle to a global Lua function, resolved once, for fast repeated calls.
+    /// \tparam Signature Function signature, e.g. `int(int, int)`.
+    /// \tparam Keys Key types (integer/string).
+    /// \param keys Key(s) of function. When multiple are provided, nested global search will be used.
+    /// \return A new moon Function. Not loaded if value is not a function.
+    template <typename Signature, typename... Keys>
+    inline Function<Signature> MakeFunction(Keys&&... keys) const {
+        Core::PushField<true>(m_state, std::forward<Keys>(keys)...);
+        return Function<Signature>::CreateAndPop(m_state);
+    }
+
+    /// Creates a coroutine running a global Lua function.
+    /// \tparam Keys Key types (integer/string).
+    /// \param keys Key(s) of function. When multiple are provided, nested global search will be used.
+    /// \return A new moon Coroutine. Not loaded if value is not a function.
+    template <typename... Keys>
+    inline Coroutine MakeCoroutine(Keys&&... keys) const {
+        Core::PushField<true>(m_state, std::forward<Keys>(keys)...);
+        return Coroutine::CreateAndPop(m_state);
+    }
+
+    /// Creates a precompiled path to a nested global value, for fast repeated access.
+    /// \tparam Keys Key types (integer/string).
+    /// \param keys Keys from outermost to innermost.
+    /// \return A new moon Path.
+    template <typename... Keys>
+    inline Path MakePath(Keys&&... keys) const {
+        return Path{m_state, std::forward<Keys>(keys)...};
+    }
+
+    /// Creates a registry of script files reloaded in place when changed.
+    /// \return A new moon ScriptRegistry.
+    [[nodiscard]] inline ScriptRegistry MakeScriptRegistry() const { return ScriptRegistry{m_state}; }
+
+    /// Interns a global or field name, for fast repeated access without hashing it again.
+    /// \param name Key name.
+    /// \return A new moon InternedKey.
+    [[nodiscard]] inline InternedKey MakeKey(std::string_view name) const { return {m_state, name}; }
+
+    /// Prints element at specified index. Shows value when possible or type otherwise.
+    /// \param index Index in stack to print.
+    /// \return String log of element.
+    [[nodiscard]] std::string StackElementToStringDump(int index) const {
+        if (!IsValidIndex(index)) {
+            Logger::Warning("tried to print element at invalid index");
+            return "";
+        }
+        index = ConvertNegativeIndex(index);
+
+        auto printArray = [this](int index, size_t size) -> std::string {
+            std::stringstream dump;
+            dump << "[";
+            for (size_t i = 1; i <= size; ++i) {
+                lua_pushinteger(m_state, i);
+                lua_gettable(m_state, index);
+                int top = GetTop();
+                if (lua_type(m_state, top) == LUA_TNIL) {
+                    break;
+                }
+                dump << StackElementToStringDump(top);
+                if (i + 1 <= size) {
+                    dump << ", ";
+                }
+                Pop();
+            }
+            dump << "]";
+            return dump.str();
+        };
+
+        auto printMap = [this](int index) -> std::string {
+            std::stringstream dump;
+            dump << "{";
+            PushNull();
+            bool first = true;
+            while (lua_next(m_state, index) != 0) {
+                if (!first) {
+                    dump << ", ";
+                }
+                first = false;
+                dump << "\"" << Get<std::string>(-2) << "\": " << StackElementToStringDump(GetTop());
+                Pop();
+            }
+            dump << "}";
+            return dump.str();
+        };
+
+        LuaType type = GetType(index);
+        switch (type) {
+            case LuaType::Boolean: {
+                return Get<bool>(index) ? "true" : "false";
+            }
+            case LuaType::Number: {
+                return std::to_string(Get<double>(index));
+            }
+            case LuaType::String: {
+                return "\"" + Get<std::string>(index) + "\"";
+            }
+            case LuaType::Table: {
+                auto size = (size_t)lua_rawlen(m_state, index);
+                return size > 0 ? printArray(index, size) : printMap(index);
+            }
+            default: {  // NOTE(mpinto): Other values, print type
+                return lua_typename(m_state, (int)type);
+            }
+        }
+    }
+
+    /// Returns current Lua stack as string. Tries to show values when possible or types otherwise.
+    /// \return String containing all current Lua stack elements.
+    [[nodiscard]] std::string GetStackDump() const {
+        int top = GetTop();
+        std::stringstream dump;
+        dump << "***** LUA STACK *****" << std::endl;
+        for (int i = 1; i <= top; ++i) {
+            int invertedIndex = top - i + 1;
+            dump << i << " (-" << invertedIndex << ") => " << StackElementToStringDump(i) << std::endl;
+        }
+        return dump.str();
+    }
+
+    /// Logs current stack to logger.
+    inline void LogStackDump() const { Logger::Info(GetStackDump()); }
+
+private:
+    /// Checks for lua status and returns if ok or not.
+    /// \param status Status code obtained from lua function.
+    /// \param errMessage Default error message to print if none is obtained from lua stack.
+    /// \return Whether or not no error occurred.
+    bool checkStatus(int status, const char* errMessage = "") const {
+        if (status != LUA_OK) {
+            const auto* msg = Get<const char*>(-1);
+            Logger::Error(msg != nullptr ? msg : errMessage);
+            Pop();
+            return false;
+        }
+        return true;
+    }
+
+    /// Statistics of calls to a global Lua function, resolved once per state and name, so calls skip the profiler lock shared by all
+    /// states. Null when instrumentation is disabled.
+    template <typename Key>
+    CallStats* callStats(const Key& key) const {
+        if constexpr (Profiler::s_enabled) {
+            std::string number;
+            std::string_view name;
+            if constexpr (std::is_arithmetic_v<Key>) {
+                number = std::to_string(key);
+                name = number;
+            } else {
+                name = std::string_view{key};
+            }
+            auto it = m_callStats.find(name);
+            if (it == m_callStats.end()) {
+                it = m_callStats.emplace(std::string{name}, &Profiler::Get(ProfileCategory::Call, name)).first;
+            }
+            return it->second;
+        } else {
+            return nullptr;
+        }
+    }
+
+    /// Panic function, reports unprotected errors before Lua aborts, as luaL_newstate does.
+    static int panic(lua_State* L) {
+        const char* msg = lua_tostring(L, -1);
+        Logger::Error(std::string("unprotected error in call to Lua API: ").append(msg != nullptr ? msg : "error object is not a string"));
+        return 0;
+    }
+
+    /// Custom allocator, must outlive Lua state.
+    std::unique_ptr<Allocator> m_allocator;
+    /// Owned Lua state.
+    lua_State* m_state{nullptr};
+    /// Global scope view bound to owned Lua state.
+    StateView m_view;
+    /// Cache of compiled chunks.
+    ChunkCache m_chunks;
+    /// Statistics of calls to global Lua functions by name, only used when instrumentation is enabled.
+    mutable std::map<std::string, CallStats*, std::less<>> m_callStats;
+};
+}  // namespace moon
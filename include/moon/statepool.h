@@ -0,0 +1,237 @@
+#pragma once
+
+#include "state.h"
+
+namespace moon {
+/// Fixed size pool of prewarmed Lua states. Every state is created, bootstrapped and snapshotted when the pool is constructed, so that no
+/// state creation happens when a state is acquired. Returned states are reset to their bootstrap baseline.
+class StatePool {
+    /// Pooled state and its bookkeeping.
+    struct Entry {
+        /// Owned state.
+        State state;
+        /// Registry reference to shallow copy of global table taken after bootstrap.
+        int baseline{LUA_NOREF};
+        /// Last thread that acquired this state.
+        std::thread::id owner{};
+        /// Whether or not state is currently leased.
+        bool busy{false};
+    };
+
+public:
+    /// Callback used to prepare each state, e.g. registering classes and functions.
+    using Bootstrap = std::function<void(State&)>;
+
+    /// Exclusive access to a pooled state. Returns state to pool when destroyed.
+    class Lease {
+    public:
+        Lease() = default;
+
+        Lease(const Lease&) = delete;
+
+        Lease(Lease&& other) noexcept : m_pool(other.m_pool), m_entry(other.m_entry) {
+            other.m_pool = nullptr;
+            other.m_entry = nullptr;
+        }
+
+        ~Lease() { Release(); }
+
+        Lease& operator=(const Lease&) = delete;
+
+        Lease& operator=(Lease&& other) noexcept {
+            if (&other == this) {
+                return *this;
+            }
+            Release();
+            m_pool = other.m_pool;
+            m_entry = other.m_entry;
+            other.m_pool = nullptr;
+            other.m_entry = nullptr;
+            return *this;
+        }
+
+        /// Checks if lease holds a valid state.
+        /// \return Whether or not a state is held.
+        [[nodiscard]] inline bool IsValid() const { return m_entry != nullptr; }
+
+        explicit operator bool() const { return IsValid(); }
+
+        State& operator*() const { return m_entry->state; }
+
+        State* operator->() const { return &m_entry->state; }
+
+        /// Resets state to baseline and returns it to pool. Lease becomes invalid.
+        void Release() {
+            if (m_entry == nullptr) {
+                return;
+            }
+            m_pool->release(m_entry);
+            m_pool = nullptr;
+            m_entry = nullptr;
+        }
+
+    private:
+        Lease(StatePool* pool, Entry* entry) : m_pool(pool), m_entry(entry) {}
+
+        /// Pool that owns leased state.
+        StatePool* m_pool{nullptr};
+        /// Leased entry.
+        Entry* m_entry{nullptr};
+
+        friend class StatePool;
+    };
+
+    /// Creates and prewarms all states of the pool.
+    /// \param size Number of states in pool.
+    /// \param bootstrap Callback applied to every state after creation.
+    /// \param scripts Lua code snippets ran in every state after bootstrap callback.
+    explicit StatePool(size_t size, Bootstrap bootstrap = {}, const std::vector<std::string>& scripts = {}) {
+        m_entries.reserve(size);
+        for (size_t i = 0; i < size; ++i) {
+            auto entry = std::make_unique<Entry>();
+            if (bootstrap) {
+                bootstrap(entry->state);
+            }
+            for (const auto& script : scripts) {
+                if (!entry->state.RunCode(script.c_str())) {
+                    Logger::Error("failed to run bootstrap script in pooled state");
+                }
+            }
+            snapshot(*entry);
+            m_entries.emplace_back(std::move(entry));
+        }
+        m_available = m_entries.size();
+    }
+
+    StatePool(const StatePool&) = delete;
+
+    StatePool(StatePool&&) = delete;
+
+    ~StatePool() = default;
+
+    StatePool& operator=(const StatePool&) = delete;
+
+    StatePool& operator=(StatePool&&) = delete;
+
+    /// Getter for total number of states in pool.
+    /// \return Pool size.
+    [[nodiscard]] inline size_t GetSize() const { return m_entries.size(); }
+
+    /// Getter for number of states not currently leased.
+    /// \return Number of available states.
+    [[nodiscard]] size_t GetAvailable() const {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        return m_available;
+    }
+
+    /// Acquires a state, blocking until one is available. States previously used by calling thread are preferred.
+    /// \return Lease of pooled state.
+    Lease Acquire() {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_condition.wait(lock, [this]() { return m_available > 0; });
+        return {this, take()};
+    }
+
+    /// Tries to acquire a state without blocking. States previously used by calling thread are preferred.
+    /// \return Lease of pooled state, invalid if none is available.
+    Lease TryAcquire() {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        if (m_available == 0) {
+            return {};
+        }
+        return {this, take()};
+    }
+
+private:
+    /// Takes a free entry, preferring one with affinity to calling thread. Must be called with mutex locked and available states.
+    /// \return Taken entry.
+    Entry* take() {
+        const auto id = std::this_thread::get_id();
+        Entry* chosen = nullptr;
+        for (const auto& entry : m_entries) {
+            if (entry->busy) {
+                continue;
+            }
+            if (entry->owner == id) {
+                chosen = entry.get();
+                break;
+            }
+            if (chosen == nullptr || (chosen->owner != std::thread::id{} && entry->owner == std::thread::id{})) {
+                chosen = entry.get();  // Prefer states never used by other threads
+            }
+        }
+        chosen->busy = true;
+        chosen->owner = id;
+        --m_available;
+        return chosen;
+    }
+
+    /// Resets entry to baseline and marks it as available.
+    /// \param entry Entry to release.
+    void release(Entry* entry) {
+        reset(*entry);
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            entry->busy = false;
+            ++m_available;
+        }
+        m_condition.notify_one();
+    }
+
+    /// Stores a shallow copy of global table in registry, to be used as baseline when resetting.
+    /// \param entry Entry to snapshot.
+    static void snapshot(Entry& entry) {
+        lua_State* L = entry.state.GetState();
+        lua_settop(L, 0);
+        lua_newtable(L);
+        lua_pushglobaltable(L);
+        lua_pushnil(L);
+        while (lua_next(L, -2) != 0) {
+            lua_pushvalue(L, -2);
+            lua_insert(L, -2);
+            lua_rawset(L, -5);
+        }
+        lua_pop(L, 1);
+        entry.baseline = luaL_ref(L, LUA_REGISTRYINDEX);
+    }
+
+    /// Resets globals to baseline, removing new ones and restoring overridden ones. Nested tables are not restored. Clears stack and collects
+    /// garbage.
+    /// \param entry Entry to reset.
+    static void reset(Entry& entry) {
+        lua_State* L = entry.state.GetState();
+        lua_settop(L, 0);
+        lua_rawgeti(L, LUA_REGISTRYINDEX, entry.baseline);
+        lua_pushglobaltable(L);
+        // Clearing existing fields while traversing is allowed
+        lua_pushnil(L);
+        while (lua_next(L, 2) != 0) {
+            lua_pop(L, 1);
+            lua_pushvalue(L, -1);
+            if (lua_rawget(L, 1) == LUA_TNIL) {
+                lua_pushvalue(L, -2);
+                lua_pushnil(L);
+                lua_rawset(L, 2);
+            }
+            lua_pop(L, 1);
+        }
+        lua_pushnil(L);
+        while (lua_next(L, 1) != 0) {
+            lua_pushvalue(L, -2);
+            lua_insert(L, -2);
+            lua_rawset(L, 2);
+        }
+        lua_settop(L, 0);
+        lua_gc(L, LUA_GCCOLLECT, 0);
+    }
+
+    /// Pooled entries. Stored as pointers so that leases stay valid.
+    std::vector<std::unique_ptr<Entry>> m_entries;
+    /// Number of states not leased.
+    size_t m_available{0};
+    /// Guards entries state.
+    mutable std::mutex m_mutex;
+    /// Signals released states.
+    std::condition_variable m_condition;
+};
+}  // namespace moon
@@ -0,0 +1,281 @@
+#pragma once
+
+#include "object.h"
+
+namespace moon {
+namespace view_detail {
+/// Lua table kept as a single registry reference, pushed on demand by views. Move only.
+class Table : public Reference {
+public:
+    Table() = default;
+
+    /// Creates a view of table at index in stack. Logs an error if value is not a table.
+    /// \param L Lua state.
+    /// \param index Index of table in stack.
+    Table(lua_State* L, int index) : m_state(L) {
+        if (!lua_istable(L, index)) {
+            Logger::Error("tried to create a table view from a value that is not a table");
+            return;
+        }
+        lua_pushvalue(L, index);
+        m_key = luaL_ref(L, LUA_REGISTRYINDEX);
+    }
+
+    /// Creates a view of table referenced by object.
+    /// \param object Object referencing table.
+    explicit Table(const Object& object) {
+        if (object.Push() == 0) {
+            return;
+        }
+        *this = Table{object.GetState(), -1};
+        lua_pop(object.GetState(), 1);
+    }
+
+    Table(const Table&) = delete;
+
+    Table(Table&& other) noexcept : Reference(std::move(other)), m_state(other.m_state) { other.m_state = nullptr; }
+
+    ~Table() {
+        if (m_state == nullptr) {
+            return;
+        }
+        Unload(m_state);
+    }
+
+    Table& operator=(const Table&) = delete;
+
+    Table& operator=(Table&& other) noexcept {
+        if (&other == this) {
+            return *this;
+        }
+        if (m_state != nullptr) {
+            Unload(m_state);
+        }
+        m_key = other.m_key;
+        m_state = other.m_state;
+        other.m_key = LUA_NOREF;
+        other.m_state = nullptr;
+        return *this;
+    }
+
+    /// Getter for the Lua state.
+    /// \return Lua state pointer.
+    [[nodiscard]] inline lua_State* GetState() const { return m_state; }
+
+protected:
+    /// Pushes table, or nil if view is not loaded.
+    inline void push() const { Reference::Push(m_state); }
+
+    /// Lua state.
+    lua_State* m_state{nullptr};
+};
+}  // namespace view_detail
+
+/// Lazy view of a Lua array, reading elements on demand instead of materializing a std::vector. Holds a single reference to the table,
+/// so each access costs one push of it and one raw index. Indexes are zero based, as in C++ containers, and element i maps to Lua index
+/// i + 1. Elements may be views themselves, e.g. ArrayView<ArrayView<int>> for nested arrays.
+/// \tparam T Element type.
+template <typename T>
+class ArrayView : public view_detail::Table {
+public:
+    /// Forward iterator converting elements when dereferenced.
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = T;
+
+        Iterator() = default;
+
+        Iterator(const ArrayView* view, size_t index) : m_view(view), m_index(index) {}
+
+        T operator*() const { return (*m_view)[m_index]; }
+
+        Iterator& operator++() {
+            ++m_index;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator previous{*this};
+            ++m_index;
+            return previous;
+        }
+
+        bool operator==(const Iterator& other) const { return m_view == other.m_view && m_index == other.m_index; }
+
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+    private:
+        const ArrayView* m_view{nullptr};
+        size_t m_index{0};
+    };
+
+    using Table::Table;
+
+    /// Getter for number of elements, the border of table as given by the length operator without metamethods.
+    /// \return Number of elements.
+    [[nodiscard]] size_t GetSize() const {
+        if (!IsLoaded()) {
+            return 0;
+        }
+        push();
+        auto size = (size_t)lua_rawlen(m_state, -1);
+        lua_pop(m_state, 1);
+        return size;
+    }
+
+    /// Checks if array has no elements.
+    /// \return Whether or not array is empty.
+    [[nodiscard]] inline bool IsEmpty() const { return GetSize() == 0; }
+
+    /// Gets element, converting it to element type.
+    /// \param index Zero based index.
+    /// \return Element. Default constructed on errors.
+    T operator[](size_t index) const {
+        if (!IsLoaded()) {
+            return Stack::DefaultReturnWithError<T>("tried to read an ArrayView not loaded");
+        }
+        push();
+        lua_rawgeti(m_state, -1, (lua_Integer)index + 1);
+        Stack::PopGuard guard{m_state, 2};
+        return Stack::GetValue<T>(m_state, -1);
+    }
+
+    /// Gets element without logging, e.g. for elements that may be missing.
+    /// \param index Zero based index.
+    /// \return Element or reason it could not be read.
+    Expected<T> At(size_t index) const {
+        if (!IsLoaded()) {
+            return ValueError::Missing;
+        }
+        push();
+        lua_rawgeti(m_state, -1, (lua_Integer)index + 1);
+        Stack::PopGuard guard{m_state, 2};
+        return Stack::TryGetValue<T>(m_state, -1);
+    }
+
+    [[nodiscard]] inline Iterator begin() const { return {this, 0}; }
+
+    [[nodiscard]] inline Iterator end() const { return {this, GetSize()}; }
+};
+
+/// Lazy view of a Lua table with string keys, reading entries on demand instead of materializing a std::map. Holds a single reference to
+/// the table, so each access costs one push of it and one field lookup. Iteration walks table with lua_next, one entry at a time, and
+/// skips entries whose key is not a string. Values may be views themselves, e.g. TableView<ArrayView<int>>.
+/// \tparam T Value type.
+template <typename T>
+class TableView : public view_detail::Table {
+public:
+    /// Forward iterator over entries, holding current entry.
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<std::string, T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        Iterator() = default;
+
+        /// Iterator at first entry of view.
+        explicit Iterator(const TableView* view) : m_view(view) { advance(true); }
+
+        reference operator*() const { return *m_entry; }
+
+        pointer operator->() const { return &*m_entry; }
+
+        Iterator& operator++() {
+            advance(false);
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return m_view == other.m_view && (m_view == nullptr || m_entry->first == other.m_entry->first);
+        }
+
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+    private:
+        /// Moves to next entry with a string key, becoming end iterator if there is none.
+        void advance(bool first) {
+            lua_State* L = m_view->m_state;
+            m_view->push();
+            if (first) {
+                lua_pushnil(L);
+            } else {
+                lua_pushlstring(L, m_entry->first.data(), m_entry->first.size());
+            }
+            while (lua_next(L, -2) != 0) {
+                if (lua_type(L, -2) == LUA_TSTRING) {
+                    size_t size;
+                    const char* key = lua_tolstring(L, -2, &size);
+                    m_entry.emplace(std::string{key, size}, Stack::GetValue<T>(L, -1));
+                    lua_pop(L, 3);
+                    return;
+                }
+                lua_pop(L, 1);
+            }
+            lua_pop(L, 1);
+            m_view = nullptr;
+            m_entry.reset();
+        }
+
+        const TableView* m_view{nullptr};
+        std::optional<value_type> m_entry{};
+    };
+
+    using Table::Table;
+
+    /// Gets value at key, converting it to value type.
+    /// \tparam Key Key type, string or integral.
+    /// \param key Key of value.
+    /// \return Value. Default constructed on errors.
+    template <typename Key>
+    T operator[](Key&& key) const {
+        if (!IsLoaded()) {
+            return Stack::DefaultReturnWithError<T>("tried to read a TableView not loaded");
+        }
+        push();
+        Stack::PushField(m_state, -1, std::forward<Key>(key));
+        Stack::PopGuard guard{m_state, 2};
+        return Stack::GetValue<T>(m_state, -1);
+    }
+
+    /// Gets value at key without logging, e.g. for optional entries.
+    /// \tparam Key Key type, string or integral.
+    /// \param key Key of value.
+    /// \return Value or reason it could not be read.
+    template <typename Key>
+    Expected<T> At(Key&& key) const {
+        if (!IsLoaded()) {
+            return ValueError::Missing;
+        }
+        push();
+        Stack::PushField(m_state, -1, std::forward<Key>(key));
+        Stack::PopGuard guard{m_state, 2};
+        return Stack::TryGetValue<T>(m_state, -1);
+    }
+
+    /// Checks if table has a non nil value at key.
+    /// \tparam Key Key type, string or integral.
+    /// \param key Key to check.
+    /// \return Whether or not key is set.
+    template <typename Key>
+    bool Contains(Key&& key) const {
+        if (!IsLoaded()) {
+            return false;
+        }
+        push();
+        Stack::PushField(m_state, -1, std::forward<Key>(key));
+        Stack::PopGuard guard{m_state, 2};
+        return !lua_isnil(m_state, -1);
+    }
+
+    [[nodiscard]] inline Iterator begin() const { return IsLoaded() ? Iterator{this} : Iterator{}; }
+
+    [[nodiscard]] inline Iterator end() const { return {}; }
+};
+}  // namespace moon
@@ -1,8 +1,33 @@
 #pragma once
 
+namespace moon {
+template <class BindableClass>
+class Binding;
+
+template <class T>
+class LuaClass;
+
+template <typename T>
+struct Borrowed;
+
+template <typename T>
+struct Owned;
+
+template <typename T>
+struct Fields;
+
+class InternedKey;
+}  // namespace moon
+
 namespace moon::meta {
 template <typename T, typename Ret = T>
-using is_bool_t = std::enable_if_t<std::is_same_v<std::decay_t<T>, bool>, Ret>;
+using is_binding_t = std::enable_if_t<std::is_same_v<decltype(T::Binding), Binding<T>>, Ret>;
+
+template <typename T>
+constexpr bool is_bool_v = std::is_same_v<std::decay_t<T>, bool>;
+
+template <typename T, typename Ret = T>
+using is_bool_t = std::enable_if_t<is_bool_v<T>, Ret>;
 
 template <typename T>
 constexpr bool is_integral_v = std::is_integral_v<std::decay_t<T>> && !std::is_same_v<std::decay_t<T>, bool>;
@@ -26,7 +51,26 @@ template <typename T, typename Ret = T>
 using is_c_string_t = std::enable_if_t<is_c_string_v<T>, Ret>;
 
 template <typename T>
-constexpr bool is_basic_string_v = is_string_v<T> || is_c_string_v<T>;
+constexpr bool is_string_view_v = std::is_same_v<std::decay_t<T>, std::string_view>;
+
+template <typename T, typename Ret = T>
+using is_string_view_t = std::enable_if_t<is_string_view_v<T>, Ret>;
+
+template <typename T>
+constexpr bool is_interned_key_v = std::is_same_v<std::decay_t<T>, InternedKey>;
+
+template <typename T, typename Ret = T>
+using is_interned_key_t = std::enable_if_t<is_interned_key_v<T>, Ret>;
+
+/// Strings with known size, pushed with lua_pushlstring and safe with embedded NULs.
+template <typename T>
+constexpr bool is_sized_string_v = is_string_v<T> || is_string_view_v<T>;
+
+template <typename T, typename Ret = T>
+using is_sized_string_t = std::enable_if_t<is_sized_string_v<T>, Ret>;
+
+template <typename T>
+constexpr bool is_basic_string_v = is_sized_string_v<T> || is_c_string_v<T>;
 
 template <typename T, typename Ret = T>
 using is_basic_string_t = std::enable_if_t<is_basic_string_v<T>, Ret>;
@@ -45,6 +89,17 @@ struct vector<std::vector<T>> : std::true_type {};
 template <typename T, typename Ret = T>
 using is_vector_t = std::enable_if_t<meta_detail::vector<std::decay_t<T>>::value, Ret>;
 
+namespace meta_detail {
+template <typename T>
+struct array : std::false_type {};
+
+template <typename T, size_t N>
+struct array<std::array<T, N>> : std::true_type {};
+}  // namespace meta_detail
+
+template <typename T, typename Ret = T>
+using is_array_t = std::enable_if_t<meta_detail::array<std::decay_t<T>>::value, Ret>;
+
 namespace meta_detail {
 template <typename T>
 struct map : std::false_type {};
@@ -54,6 +109,12 @@ struct map<std::unordered_map<std::string, T>> : std::true_type {};
 
 template <typename T>
 struct map<std::map<std::string, T>> : std::true_type {};
+
+template <typename T>
+struct map<std::unordered_map<std::string_view, T>> : std::true_type {};
+
+template <typename T>
+struct map<std::map<std::string_view, T>> : std::true_type {};
 }  // namespace meta_detail
 
 template <typename T, typename Ret = T>
@@ -93,6 +154,20 @@ constexpr bool is_tuple_v = meta_detail::tuple<std::decay_t<T>>::value;
 template <typename T, typename Ret = T>
 using is_tuple_t = std::enable_if_t<is_tuple_v<T>, Ret>;
 
+namespace meta_detail {
+template <typename T, typename = void>
+struct described : std::false_type {};
+
+template <typename T>
+struct described<T, std::void_t<decltype(Fields<T>::value)>> : std::true_type {};
+}  // namespace meta_detail
+
+template <typename T>
+constexpr bool is_described_v = meta_detail::described<std::decay_t<T>>::value;
+
+template <typename T, typename Ret = T>
+using is_described_t = std::enable_if_t<is_described_v<T>, Ret>;
+
 template <typename T, typename... Ts>
 constexpr bool none_is_v = !std::disjunction_v<std::is_same<T, Ts>...>;
 
@@ -206,6 +281,40 @@ struct is_callable<
 template <typename T>
 constexpr bool is_callable_v = meta_detail::is_callable<std::decay_t<T>>::value;
 
+namespace meta_detail {
+template <typename T, typename = void>
+struct function_traits {};
+
+template <typename Ret, typename... Args>
+struct function_traits<Ret (*)(Args...)> {
+    using return_type = Ret;
+    using arguments = std::tuple<Args...>;
+};
+
+template <typename Ret, typename... Args>
+struct function_traits<Ret (*)(Args...) noexcept> : function_traits<Ret (*)(Args...)> {};
+
+template <typename C, typename Ret, typename... Args>
+struct function_traits<Ret (C::*)(Args...)> : function_traits<Ret (*)(Args...)> {};
+
+template <typename C, typename Ret, typename... Args>
+struct function_traits<Ret (C::*)(Args...) const> : function_traits<Ret (*)(Args...)> {};
+
+template <typename C, typename Ret, typename... Args>
+struct function_traits<Ret (C::*)(Args...) noexcept> : function_traits<Ret (*)(Args...)> {};
+
+template <typename C, typename Ret, typename... Args>
+struct function_traits<Ret (C::*)(Args...) const noexcept> : function_traits<Ret (*)(Args...)> {};
+
+template <typename T>
+struct function_traits<T, std::enable_if_t<std::is_class_v<T>, std::void_t<decltype(&T::operator())>>>
+    : function_traits<decltype(&T::operator())> {};
+}  // namespace meta_detail
+
+/// Return and argument types of a function pointer, member function pointer or non generic functor.
+template <typename T>
+using function_traits = meta_detail::function_traits<std::decay_t<T>>;
+
 template <typename T>
 using convert_to_tuple_t = std::conditional_t<is_tuple_v<T>, T, std::tuple<T>>;
 
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "object.h"
+
+namespace moon {
+namespace transfer_detail {
+/// Deepest table nesting transferred, which bounds recursion.
+constexpr int MAX_DEPTH{200};
+
+/// Copies values from one state to another, walking tables once. Tables already copied are tracked by id, with a table in source
+/// mapping original tables to their id and a table in destination holding copies by id.
+struct Copier {
+    lua_State* source;
+    lua_State* destination;
+    /// Index, in source, of table mapping tables copied to their id.
+    int ids;
+    /// Index, in destination, of table holding copies by id.
+    int copies;
+    /// Number of tables copied.
+    lua_Integer tables{0};
+    /// Error message, only built on errors.
+    std::string error{};
+
+    bool Table(int index, int depth) {
+        if (depth >= MAX_DEPTH) {
+            error = "tables nested too deep to transfer";
+            return false;
+        }
+        lua_pushvalue(source, index);
+        if (lua_rawget(source, ids) == LUA_TNUMBER) {  // Shared table, reuse copy
+            lua_rawgeti(destination, copies, lua_tointeger(source, -1));
+            lua_pop(source, 1);
+            return true;
+        }
+        lua_pop(source, 1);
+        lua_createtable(destination, (int)lua_rawlen(source, index), 0);
+        int table = lua_gettop(destination);
+        lua_pushvalue(source, index);
+        lua_pushinteger(source, ++tables);
+        lua_rawset(source, ids);
+        lua_pushvalue(destination, table);
+        lua_rawseti(destination, copies, tables);
+
+        lua_pushnil(source);
+        while (lua_next(source, index) != 0) {
+            int top = lua_gettop(source);
+            if (!Value(top - 1, depth + 1) || !Value(top, depth + 1)) {
+                return false;
+            }
+            lua_rawset(destination, table);
+            lua_pop(source, 1);
+        }
+        return true;
+    }
+
+    bool Value(int index, int depth) {
+        if (!lua_checkstack(source, 4) || !lua_checkstack(destination, 4)) {
+            error = "not enough stack space to transfer value";
+            return false;
+        }
+        switch (lua_type(source, index)) {
+            case LUA_TNIL:
+                lua_pushnil(destination);
+                return true;
+            case LUA_TBOOLEAN:
+                lua_pushboolean(destination, lua_toboolean(source, index));
+                return true;
+            case LUA_TNUMBER:
+                if (lua_isinteger(source, index)) {
+                    lua_pushinteger(destination, lua_tointeger(source, index));
+                } else {
+                    lua_pushnumber(destination, lua_tonumber(source, index));
+                }
+                return true;
+            case LUA_TSTRING: {
+                size_t size;
+                const char* data = lua_tolstring(source, index, &size);
+                lua_pushlstring(destination, data, size);
+                return true;
+            }
+            case LUA_TLIGHTUSERDATA:
+                lua_pushlightuserdata(destination, lua_touserdata(source, index));
+                return true;
+            case LUA_TTABLE:
+                return Table(index, depth);
+            default:
+                error = std::string("can not transfer value of type ") + lua_typename(source, lua_type(source, index));
+                return false;
+        }
+    }
+};
+
+/// Main thread of state, shared by all its threads.
+inline lua_State* mainThread(lua_State* L) {
+    lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+    lua_State* main = lua_tothread(L, -1);
+    lua_pop(L, 1);
+    return main;
+}
+}  // namespace transfer_detail
+
+/// Copies value at index in source state and pushes it to destination state, with no intermediate C++ containers. Tables are walked
+/// once, and a table referenced from several places, including cycles, is copied once, so structure is kept. The value is pushed as is
+/// when both are threads of the same state. Functions, userdata and threads can not be transferred, and metatables are not kept.
+/// \param source State to copy from.
+/// \param index Index of value in source stack.
+/// \param destination State to push copy to.
+/// \return Whether or not value was transferred. Nothing is pushed to destination on errors.
+inline bool Transfer(lua_State* source, int index, lua_State* destination) {
+    index = lua_absindex(source, index);
+    if (transfer_detail::mainThread(source) == transfer_detail::mainThread(destination)) {
+        lua_pushvalue(source, index);
+        if (source != destination) {
+            lua_xmove(source, destination, 1);
+        }
+        return true;
+    }
+    int sourceTop = lua_gettop(source);
+    int destinationTop = lua_gettop(destination);
+    lua_newtable(source);
+    lua_newtable(destination);
+    transfer_detail::Copier copier{source, destination, lua_gettop(source), lua_gettop(destination)};
+    bool transferred = copier.Value(index, 0);
+    lua_settop(source, sourceTop);
+    if (!transferred) {
+        lua_settop(destination, destinationTop);
+        return Stack::DefaultReturnWithError<bool>(std::move(copier.error));
+    }
+    lua_remove(destination, -2);
+    return true;
+}
+
+/// Copies value referenced by object to destination state.
+/// \param object Object to copy.
+/// \param destination State to copy to.
+/// \return Object referencing copy in destination, not loaded on errors.
+inline Object Transfer(const Object& object, lua_State* destination) {
+    if (!object.IsLoaded()) {
+        return Stack::DefaultReturnWithError<Object>("tried to transfer an Object not loaded");
+    }
+    object.Push();
+    Stack::PopGuard guard{object.GetState()};
+    if (!Transfer(object.GetState(), -1, destination)) {
+        return Object{};
+    }
+    return Object::CreateAndPop(destination);
+}
+}  // namespace moon
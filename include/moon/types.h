@@ -15,4 +15,86 @@ enum class LuaType {
     UserData = LUA_TUSERDATA,
     Thread = LUA_TTHREAD
 };
+
+/// Data member of a described struct.
+/// \tparam T Struct type.
+/// \tparam U Data member type.
+template <typename T, typename U>
+struct Field {
+    /// Table field name.
+    const char* name;
+    /// Data member pointer.
+    U T::*member;
+};
+
+/// Creates a field of a described struct.
+/// \param name Table field name.
+/// \param member Data member pointer.
+/// \return Field.
+template <typename T, typename U>
+constexpr Field<T, U> MakeField(const char* name, U T::*member) {
+    return {name, member};
+}
+
+/// Describes a plain struct as a table, so it is read from and pushed to Lua field by field, in a single traversal of the table.
+/// Specialize with a static constexpr tuple of fields named value, e.g.
+/// template <> struct moon::Fields<Point> { static constexpr auto value = std::make_tuple(moon::MakeField("x", &Point::x)); };
+/// \tparam T Struct type. Must be default constructible.
+template <typename T>
+struct Fields {};
+
+/// Reasons a value could not be read from Lua.
+enum class ValueError {
+    /// Value was read.
+    None,
+    /// Value, or a table along its path, is nil, or index is not valid.
+    Missing,
+    /// Value is not convertible to requested type.
+    TypeMismatch,
+    /// Number does not fit in requested type.
+    OutOfRange
+};
+
+/// Value read from Lua or the reason it could not be read. No message is built on failure, so it is cheap to check in hot loops.
+/// \tparam T Value type.
+template <typename T>
+class Expected {
+public:
+    Expected(T value) : m_value(std::move(value)) {}
+
+    Expected(ValueError error) : m_error(error) {}
+
+    /// Checks if value was read.
+    /// \return Whether or not there is a value.
+    [[nodiscard]] inline bool HasValue() const { return m_error == ValueError::None; }
+
+    explicit operator bool() const { return HasValue(); }
+
+    /// Getter for the reason value could not be read.
+    /// \return Error, None if there is a value.
+    [[nodiscard]] inline ValueError GetError() const { return m_error; }
+
+    /// Getter for the value. Default constructed if there is none.
+    /// \return Value.
+    [[nodiscard]] inline const T& GetValue() const& { return m_value; }
+
+    inline T& GetValue() & { return m_value; }
+
+    inline T&& GetValue() && { return std::move(m_value); }
+
+    /// Getter for the value or a fallback.
+    /// \param fallback Returned if there is no value.
+    /// \return Value or fallback.
+    [[nodiscard]] inline T ValueOr(T fallback) const { return HasValue() ? m_value : fallback; }
+
+    inline const T& operator*() const { return m_value; }
+
+    inline const T* operator->() const { return &m_value; }
+
+private:
+    /// Value read.
+    T m_value{};
+    /// Reason value could not be read.
+    ValueError m_error{ValueError::None};
+};
 }  // namespace moon
@@ -1,6 +1,48 @@
 #pragma once
 
+#include "stack.h"
+
 namespace moon {
+/// Who releases a C++ object pushed to Lua, chosen per push instead of per class.
+enum class Ownership {
+    /// C++ keeps ownership, and object must outlive its userdata.
+    Borrowed = 1,
+    /// Lua takes ownership, and object is deleted when its userdata is collected.
+    Owned,
+    /// Ownership is shared, and userdata holds a std::shared_ptr until collected.
+    Shared
+};
+
+/// Pointer pushed to Lua as borrowed, see moon::Borrow.
+template <typename T>
+struct Borrowed {
+    T* pointer;
+};
+
+/// Pointer pushed to Lua as owned, see moon::Own.
+template <typename T>
+struct Owned {
+    T* pointer;
+};
+
+/// Marks a pointer to be pushed as borrowed, e.g. `Moon::Push(moon::Borrow(&entity))`, regardless of class GC.
+/// \tparam T Bound class.
+/// \param pointer Object kept alive by C++.
+/// \return Borrowed pointer.
+template <typename T>
+constexpr Borrowed<T> Borrow(T* pointer) {
+    return {pointer};
+}
+
+/// Marks a pointer to be pushed as owned, handing it over to Lua regardless of class GC.
+/// \tparam T Bound class.
+/// \param pointer Object allocated with new.
+/// \return Owned pointer.
+template <typename T>
+constexpr Owned<T> Own(T* pointer) {
+    return {pointer};
+}
+
 /**
  * @brief Converts C++ class to Lua metatable.
  * LunaFive modded - http://lua-users.org/wiki/LunaFive
@@ -17,14 +59,98 @@ public:
         int (T::*getter)(lua_State*);
 
         int (T::*setter)(lua_State*);
+
+        /// Generated accessors. Default ones call getter and setter methods.
+        int (*get)(lua_State*, T*, const PropertyType&){&LuaClass<T>::method_get};
+
+        int (*set)(lua_State*, T*, const PropertyType&){&LuaClass<T>::method_set};
+
+        /// Type erased data member pointer, for typed data member properties.
+        char T::*member{nullptr};
     };
 
     struct FunctionType {
         const char* name;
 
         int (T::*func)(lua_State*);
+
+        /// Generated dispatcher. Default one calls func with object removed from stack.
+        lua_CFunction dispatch{&LuaClass<T>::function_dispatch};
+
+        /// Type erased member function pointer, for typed methods.
+        void (T::*method)(){nullptr};
+
+        /// Whether or not dispatcher finds method by its index upvalue. Methods known at compile time are dispatched without it.
+        bool indexed{true};
     };
 
+    /**
+     * @brief Creates a method from a typed member function pointer, with arguments and return marshalled at compile time.
+     * Methods with `int (T::*)(lua_State*)` signature keep receiving the Lua state directly.
+     *
+     * @tparam M Member function pointer type
+     * @param name Method name
+     * @param method Member function pointer
+     * @return FunctionType
+     */
+    template <typename M>
+    static FunctionType MakeMethod(const char* name, M method) {
+        static_assert(std::is_member_function_pointer_v<M>, "methods must be member function pointers");
+        if constexpr (std::is_same_v<M, int (T::*)(lua_State*)>) {
+            return {name, method};
+        } else {
+            return {name, nullptr, &LuaClass<T>::method_dispatch<M>, reinterpret_cast<void (T::*)()>(method)};
+        }
+    }
+
+    /**
+     * @brief Creates a method at compile time from a member function pointer given as template argument, e.g. for binding tables.
+     * Dispatcher is generated for that exact method, so no type erased pointer is stored or cast back.
+     *
+     * @tparam method Member function pointer
+     * @param name Method name
+     * @return FunctionType
+     */
+    template <auto method>
+    static constexpr FunctionType MakeMethod(const char* name) {
+        using M = decltype(method);
+        static_assert(std::is_member_function_pointer_v<M>, "methods must be member function pointers");
+        if constexpr (std::is_same_v<M, int (T::*)(lua_State*)>) {
+            return {name, method, &LuaClass<T>::bound_function_dispatch<method>, nullptr, false};
+        } else {
+            return {name, nullptr, &LuaClass<T>::bound_method_dispatch<method>, nullptr, false};
+        }
+    }
+
+    /**
+     * @brief Creates a property at compile time from a data member pointer given as template argument, e.g. for binding tables.
+     *
+     * @tparam member Data member pointer
+     * @param name Property name
+     * @return PropertyType
+     */
+    template <auto member>
+    static constexpr PropertyType MakeProperty(const char* name) {
+        static_assert(std::is_member_object_pointer_v<decltype(member)>, "properties must be data member pointers");
+        return {name, nullptr, nullptr, &LuaClass<T>::bound_member_get<member>, &LuaClass<T>::bound_member_set<member>};
+    }
+
+    /**
+     * @brief Creates a property from a typed data member pointer, converted with Stack::GetValue and Stack::PushValue.
+     * Const data members are read only.
+     *
+     * @tparam U Data member type
+     * @param name Property name
+     * @param member Data member pointer
+     * @return PropertyType
+     */
+    template <typename U>
+    static PropertyType MakeProperty(const char* name, U T::*member) {
+        static_assert(!std::is_function_v<U>, "properties must be data member pointers");
+        auto erased = reinterpret_cast<char T::*>(const_cast<std::remove_const_t<U> T::*>(member));
+        return {name, nullptr, nullptr, &LuaClass<T>::member_get<U>, &LuaClass<T>::member_set<U>, erased};
+    }
+
     /**
      * @brief Retrieves a wrapped class from the arguments passed to the func, specified by narg (position).
      * This func will raise an exception if the argument is not of the correct type.
@@ -82,61 +208,269 @@ public:
             lua_setglobal(L, T::Binding.GetName());
         }
 
-        luaL_newmetatable(L, T::Binding.GetName());
-        int metatable = lua_gettop(L);
-
-        lua_pushstring(L, "__tostring");
-        lua_pushcfunction(L, &LuaClass<T>::to_string);
-        lua_settable(L, metatable);
-        // To be able to compare two Luna objects (not natively possible with full userdata)
-        lua_pushstring(L, "__eq");
-        lua_pushcfunction(L, &LuaClass<T>::equals);
-        lua_settable(L, metatable);
-
-        lua_pushstring(L, "__index");
-        lua_pushcfunction(L, &LuaClass<T>::property_getter);
-        lua_settable(L, metatable);
-
-        lua_pushstring(L, "__newindex");
-        lua_pushcfunction(L, &LuaClass<T>::property_setter);
-        lua_settable(L, metatable);
-
-        if (T::Binding.GetGC()) {
-            lua_pushstring(L, "__gc");
-            lua_pushcfunction(L, &LuaClass<T>::gc_obj);
-            lua_settable(L, metatable);
-        }
-
-        unsigned i = 0;
-        for (const auto& property : T::Binding.GetProperties()) {  // Register some properties in it
-            lua_pushstring(L, property.name);                      // Having some string associated with them
-            lua_pushnumber(L, i++);                                // And an index of which property it is
-            lua_settable(L, metatable);
+        if (!T::Binding.GetLazy()) {
+            PushMetatable(L);
+            lua_pop(L, 1);
         }
+    }
 
-        i = 0;
-        for (const auto& method : T::Binding.GetMethods()) {
-            lua_pushstring(L, method.name);       // Register some functions in it
-            lua_pushnumber(L, i++ | (1u << 8u));  // Add a number indexing which func it is
-            lua_settable(L, metatable);
+    /**
+     * @brief Pushes class metatable, creating it if this is its first use in state.
+     * Classes with lazy registration only get their metatable here, when first object is constructed or pushed.
+     *
+     * @param L Lua State
+     */
+    static void PushMetatable(lua_State* L) {
+        if (luaL_getmetatable(L, T::Binding.GetName()) != LUA_TNIL) {
+            return;
         }
         lua_pop(L, 1);
+        createMetatable(L);
     }
 
     /**
      * @brief Loads an instance of the class into the Lua stack, and provides you a pointer so you can modify it.
+     * Class GC picks ownership, owned if set and borrowed otherwise. Goes through identity cache like explicit policies, reusing
+     * userdata already pushed for instance, whatever its ownership.
      *
      * @param L Lua State
-     * @param instance Instance to push
+     * @param instance Instance to push, nil if null
      */
     static void Push(lua_State* L, T* instance) {
-        T** a = static_cast<T**>(lua_newuserdata(L, sizeof(T*)));  // Create userdata
-        *a = instance;
-        luaL_getmetatable(L, T::Binding.GetName());
-        lua_setmetatable(L, -2);
+        push(L, instance, T::Binding.GetGC() ? Ownership::Owned : Ownership::Borrowed, nullptr, true);
+    }
+
+    /**
+     * @brief Loads a borrowed instance, reusing userdata already pushed for it in state, so pushing the same object again allocates
+     * nothing and compares equal without calling __eq. Reused userdata may be owned or shared, which keeps instance alive anyway.
+     *
+     * @param L Lua State
+     * @param instance Instance to push, nil if null
+     */
+    static void Push(lua_State* L, const Borrowed<T>& instance) { push(L, instance.pointer, Ownership::Borrowed, nullptr); }
+
+    /**
+     * @brief Loads an owned instance, deleted when collected. Reuses userdata already owning instance, if any, and takes over borrowed
+     * userdata of instance. Refused with an error if instance is already shared with Lua.
+     *
+     * @param L Lua State
+     * @param instance Instance to push, nil if null
+     */
+    static void Push(lua_State* L, const Owned<T>& instance) { push(L, instance.pointer, Ownership::Owned, nullptr); }
+
+    /**
+     * @brief Loads a shared instance, holding a reference to it until collected. Reuses userdata already sharing instance, if any.
+     * Refused with an error if instance is already owned by Lua, since both would release it.
+     *
+     * @param L Lua State
+     * @param instance Instance to push, nil if null
+     */
+    static void Push(lua_State* L, std::shared_ptr<T> instance) {
+        T* pointer = instance.get();
+        push(L, pointer, Ownership::Shared, &instance);
     }
 
 private:
+    /**
+     * @brief Pushes instance with ownership tagged in userdata user value, through weak valued identity cache of class (internal)
+     *
+     * @param L Lua State
+     * @param instance Instance to push
+     * @param ownership Ownership of userdata
+     * @param shared Shared pointer moved into userdata, for shared ownership
+     * @param adopt Whether or not to reuse cached userdata whatever its ownership, for pushes with no explicit policy
+     */
+    static void push(lua_State* L, T* instance, Ownership ownership, std::shared_ptr<T>* shared, bool adopt = false) {
+        if (instance == nullptr) {
+            lua_pushnil(L);
+            return;
+        }
+        pushCache(L);
+        if (lua_rawgetp(L, -1, instance) == LUA_TUSERDATA) {
+            lua_getiuservalue(L, -1, 1);
+            auto cached = (Ownership)lua_tointeger(L, -1);  // s_inlineTag, not an Ownership, for objects stored inline
+            lua_pop(L, 1);
+            if (cached == Ownership::Borrowed && ownership == Ownership::Owned) {
+                lua_pushinteger(L, (lua_Integer)ownership);  // Borrowed userdata takes over, so instance keeps a single userdata
+                lua_setiuservalue(L, -2, 1);
+                cached = ownership;
+            }
+            if (ownership == Ownership::Borrowed || cached == ownership || adopt) {
+                lua_remove(L, -2);  // Cache
+                return;
+            }
+            if (cached != Ownership::Borrowed) {  // Owned, shared, or stored inline and so owned by Lua
+                lua_pop(L, 2);
+                lua_pushnil(L);
+                Logger::Error(std::string{"tried to push "} + T::Binding.GetName() + " with another ownership than the one Lua already has");
+                return;
+            }
+        }
+        lua_pop(L, 1);  // Borrowed userdata only points to instance, so it stays valid when replaced in cache by a shared one
+
+        bool isShared = ownership == Ownership::Shared;
+        void* storage = lua_newuserdatauv(L, isShared ? sharedOffset() + sizeof(std::shared_ptr<T>) : sizeof(T*), 1);
+        *static_cast<T**>(storage) = instance;
+        if (isShared) {
+            new (sharedAddress(storage)) std::shared_ptr<T>(std::move(*shared));
+        }
+        lua_pushinteger(L, (lua_Integer)ownership);
+        lua_setiuservalue(L, -2, 1);
+        PushMetatable(L);
+        lua_setmetatable(L, -2);
+        lua_pushvalue(L, -1);
+        lua_rawsetp(L, -3, instance);
+        lua_remove(L, -2);  // Cache
+    }
+
+    /**
+     * @brief Pushes identity cache of class in state, mapping instances to their userdata, creating it if needed (internal)
+     * Values are weak, so cache never keeps userdata alive.
+     *
+     * @param L Lua State
+     */
+    static void pushCache(lua_State* L) {
+        if (lua_rawgetp(L, LUA_REGISTRYINDEX, &s_cacheKey) == LUA_TTABLE) {
+            return;
+        }
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_createtable(L, 0, 1);
+        lua_pushstring(L, "v");
+        lua_setfield(L, -2, "__mode");
+        lua_setmetatable(L, -2);
+        lua_pushvalue(L, -1);
+        lua_rawsetp(L, LUA_REGISTRYINDEX, &s_cacheKey);
+    }
+
+    /**
+     * @brief Registers userdata at top of stack in identity cache of class, under its instance (internal)
+     *
+     * @param L Lua State
+     * @param instance Instance held by userdata
+     */
+    static void cacheUserData(lua_State* L, T* instance) {
+        pushCache(L);
+        lua_pushvalue(L, -2);
+        lua_rawsetp(L, -2, instance);
+        lua_pop(L, 1);
+    }
+
+    /**
+     * @brief Offset of shared pointer in userdata of shared instances, right after the pointer to object (internal)
+     *
+     * @return size_t
+     */
+    static constexpr size_t sharedOffset() {
+        constexpr size_t alignment = alignof(std::shared_ptr<T>);
+        return (sizeof(T*) + alignment - 1) / alignment * alignment;
+    }
+
+    /**
+     * @brief Address of shared pointer in userdata of shared instances (internal)
+     *
+     * @param storage Userdata block
+     * @return std::shared_ptr<T>*
+     */
+    static inline std::shared_ptr<T>* sharedAddress(void* storage) {
+        return reinterpret_cast<std::shared_ptr<T>*>(static_cast<char*>(storage) + sharedOffset());
+    }
+
+    /**
+     * @brief Creates class metatable, with methods and properties tables, leaving it at top of stack (internal)
+     *
+     * @param L Lua State
+     */
+    static void createMetatable(lua_State* L) {
+        // Presized for __name, __gc, __tostring, __eq, __index and __newindex, and stored in registry as luaL_newmetatable does
+        lua_createtable(L, 0, 6);
+        int metatable = lua_gettop(L);
+        lua_pushstring(L, T::Binding.GetName());
+        lua_setfield(L, metatable, "__name");
+        lua_pushvalue(L, metatable);
+        lua_setfield(L, LUA_REGISTRYINDEX, T::Binding.GetName());
+        luaL_setfuncs(L, s_metamethods, 0);
+
+        // Methods are created once, as closures that receive the object as first argument, and looked up by a plain table hit
+        const auto& methods = T::Binding.GetMethods();
+        lua_createtable(L, 0, (int)methods.size());
+        int methodsTable = lua_gettop(L);
+        const luaL_Reg* functions = T::Binding.GetFunctions();
+        if (functions != nullptr && !Profiler::s_enabled) {
+            // Binding table methods need no index, so they share upvalues and are set in one pass
+            lua_pushinteger(L, 0);
+            lua_pushvalue(L, metatable);
+            luaL_setfuncs(L, functions, 2);
+        } else {
+            for (size_t i = 0; i < methods.size(); ++i) {
+                lua_pushinteger(L, (lua_Integer)i);  // Index of which func it is
+                lua_pushvalue(L, metatable);         // Metatable, to validate object
+                if constexpr (Profiler::s_enabled) {
+                    lua_pushlightuserdata(L, &Profiler::Get(ProfileCategory::Method, std::string{T::Binding.GetName()} + ":" + methods[i].name));
+                }
+                lua_pushcclosure(L, methods[i].dispatch, 2 + s_statsUpvalues);
+                lua_setfield(L, methodsTable, methods[i].name);
+            }
+        }
+
+        // Properties are resolved to their index at registration time
+        const auto& properties = T::Binding.GetProperties();
+        lua_createtable(L, 0, (int)properties.size());
+        int propertiesTable = lua_gettop(L);
+        for (size_t i = 0; i < properties.size(); ++i) {
+            lua_pushinteger(L, (lua_Integer)i);
+            lua_setfield(L, propertiesTable, properties[i].name);
+        }
+        if constexpr (Profiler::s_enabled) {
+            // Getter and setter statistics of each property, kept as upvalue of accessors
+            auto** stats = static_cast<CallStats**>(lua_newuserdata(L, sizeof(CallStats*) * 2 * properties.size()));
+            for (size_t i = 0; i < properties.size(); ++i) {
+                std::string name = std::string{T::Binding.GetName()} + "." + properties[i].name;
+                stats[2 * i] = &Profiler::Get(ProfileCategory::Property, name + " (get)");
+                stats[2 * i + 1] = &Profiler::Get(ProfileCategory::Property, name + " (set)");
+            }
+        }
+        int statsArray = lua_gettop(L);
+
+        if (properties.empty()) {
+            lua_pushvalue(L, methodsTable);
+        } else {
+            lua_pushvalue(L, methodsTable);
+            lua_pushvalue(L, propertiesTable);
+            if constexpr (Profiler::s_enabled) {
+                lua_pushvalue(L, statsArray);
+            }
+            lua_pushcclosure(L, &LuaClass<T>::property_getter, 2 + s_statsUpvalues);
+        }
+        lua_setfield(L, metatable, "__index");
+
+        lua_pushvalue(L, methodsTable);
+        lua_pushvalue(L, propertiesTable);
+        if constexpr (Profiler::s_enabled) {
+            lua_pushvalue(L, statsArray);
+        }
+        lua_pushcclosure(L, &LuaClass<T>::property_setter, 2 + s_statsUpvalues);
+        lua_setfield(L, metatable, "__newindex");
+
+        lua_settop(L, metatable);  // Pop methods and properties tables and statistics
+    }
+
+    /// Metamethods of every class. __gc is always set, since owned and shared instances can be pushed even after RemoveGC. To be able to
+    /// compare two Luna objects, which is not natively possible with full userdata, __eq compares pointers.
+    static constexpr luaL_Reg s_metamethods[]{{"__gc", &LuaClass<T>::gc_obj},
+                                              {"__tostring", &LuaClass<T>::to_string},
+                                              {"__eq", &LuaClass<T>::equals},
+                                              {nullptr, nullptr}};
+
+    /// User value tag of objects stored inline in their userdata, apart from Ownership tags of pushed objects.
+    static constexpr lua_Integer s_inlineTag{0};
+
+    /// Address used as registry key of identity cache, unique per class.
+    static inline char s_cacheKey{};
+
+    /// Number of upvalues holding call site statistics, the last ones of every method and property accessor.
+    static constexpr int s_statsUpvalues{Profiler::s_enabled ? 1 : 0};
+
     /**
      * @brief constructor (internal)
      *
@@ -144,106 +478,326 @@ private:
      * @return int
      */
     static int constructor(lua_State* L) {
-        T* ap = new T(L);
-        T** a = static_cast<T**>(lua_newuserdata(L, sizeof(T*)));  // Push value = userdata
-        *a = ap;
+        if (T::Binding.GetInline()) {
+            // Single allocation, with object stored right after its own pointer. Userdata is already at top of stack when constructing.
+            void* storage = lua_newuserdata(L, inlineOffset() + sizeof(T));
+            *static_cast<T**>(storage) = new (inlineAddress(storage)) T(L);
+            lua_pushinteger(L, s_inlineTag);  // Storage kind is tagged, so collection never guesses it from size
+            lua_setiuservalue(L, -2, 1);
+            cacheUserData(L, *static_cast<T**>(storage));  // Pushes of object from C++ must never get an owner of their own
+        } else {
+            T* ap = new T(L);
+            T** a = static_cast<T**>(lua_newuserdata(L, sizeof(T*)));  // Push value = userdata
+            *a = ap;
+            lua_pushinteger(L, (lua_Integer)(T::Binding.GetGC() ? Ownership::Owned : Ownership::Borrowed));
+            lua_setiuservalue(L, -2, 1);
+            cacheUserData(L, ap);  // Pushes of object from C++, e.g. of this in a method, reuse its userdata
+        }
 
-        luaL_getmetatable(L, T::Binding.GetName());  // Fetch global metatable T::classname
+        PushMetatable(L);  // Fetch global metatable T::classname, creating it on first use
         lua_setmetatable(L, -2);
         return 1;
     }
 
+    /**
+     * @brief Offset of object in userdata when stored inline (internal)
+     * Object is stored right after the pointer to itself, to keep the same layout as boxed objects.
+     *
+     * @return size_t
+     */
+    static constexpr size_t inlineOffset() {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "over aligned classes are not supported");
+        return (sizeof(T*) + alignof(T) - 1) / alignof(T) * alignof(T);
+    }
+
+    /**
+     * @brief Address of object stored inline in userdata (internal)
+     *
+     * @param storage Userdata block
+     * @return T*
+     */
+    static inline T* inlineAddress(void* storage) { return reinterpret_cast<T*>(static_cast<char*>(storage) + inlineOffset()); }
+
     /**
      * @brief property_getter (internal)
+     * Upvalues are methods table and properties table, respectively.
      *
      * @param L Lua State
      * @return int
      */
     static int property_getter(lua_State* L) {
-        lua_getmetatable(L, 1);  // Look up the index of a name
-        lua_pushvalue(L, 2);     // Push the name
-        lua_rawget(L, -2);       // Get the index
+        lua_pushvalue(L, 2);  // Push the name
+        if (lua_rawget(L, lua_upvalueindex(1)) != LUA_TNIL) {
+            return 1;  // Return a func
+        }
+        lua_pop(L, 1);
 
-        if (lua_isnumber(L, -1) != 0) {  // Check if we got a valid index
-            auto _index = static_cast<unsigned>(lua_tonumber(L, -1));
+        lua_pushvalue(L, 2);
+        if (lua_rawget(L, lua_upvalueindex(2)) != LUA_TNUMBER) {  // Check if we got a valid property index
+            lua_pushnil(L);
+            return 1;
+        }
+        auto _index = (size_t)lua_tointeger(L, -1);
+        T** obj = static_cast<T**>(lua_touserdata(L, 1));
+        const auto& property = T::Binding.GetProperties()[_index];
 
-            T** obj = static_cast<T**>(lua_touserdata(L, 1));
+        auto sample = Profiler::Begin(L);
+        int results = property.get(L, *obj, property);
+        Profiler::End(L, propertyStats(L, 2 * _index), sample);
+        return results;
+    }
 
-            lua_pushvalue(L, 3);
+    /**
+     * @brief property_setter (internal)
+     * Upvalues are methods table and properties table, respectively.
+     *
+     * @param L Lua State
+     * @return int
+     */
+    static int property_setter(lua_State* L) {
+        T** obj = static_cast<T**>(lua_touserdata(L, 1));
 
-            // A func
-            if ((_index & (1u << 8u)) != 0u) {
-                lua_pushnumber(L, _index ^ (1u << 8u));  // Push the right func index
-                lua_pushlightuserdata(L, obj);
-                lua_pushcclosure(L, &LuaClass<T>::function_dispatch, 2);
-                return 1;  // Return a func
-            }
+        if (!obj || !*obj) {
+            luaL_error(L, "Internal error, no object given!");
+            return 0;
+        }
 
-            lua_pop(L, 2);     // Pop metatable and _index
-            lua_remove(L, 1);  // Remove userdata
-            lua_remove(L, 1);  // Remove [key]
+        lua_pushvalue(L, 2);
+        if (lua_rawget(L, lua_upvalueindex(1)) != LUA_TNIL) {  // Try to set a func
+            luaL_error(L, "Moon: Trying to set the method [%s] of class [%s]", lua_tostring(L, 2), T::Binding.GetName());
+            return 0;
+        }
+        lua_pop(L, 1);
 
-            return ((*obj)->*(T::Binding.GetProperties()[_index].getter))(L);
+        lua_pushvalue(L, 2);
+        if (lua_rawget(L, lua_upvalueindex(2)) != LUA_TNUMBER) {
+            return 0;
         }
+        auto _index = (size_t)lua_tointeger(L, -1);
+        lua_pop(L, 1);
+        const auto& property = T::Binding.GetProperties()[_index];
 
-        return 1;
+        auto sample = Profiler::Begin(L);
+        int results = property.set(L, *obj, property);
+        Profiler::End(L, propertyStats(L, 2 * _index + 1), sample);
+        return results;
     }
 
     /**
-     * @brief property_setter (internal)
+     * @brief Calls property getter method, with an empty stack (internal)
      *
      * @param L Lua State
+     * @param obj Object
+     * @param property Property
      * @return int
      */
-    static int property_setter(lua_State* L) {
-        lua_getmetatable(L, 1);  // Look up the index from name
-        lua_pushvalue(L, 2);     //
-        lua_rawget(L, -2);       //
-
-        if (lua_isnumber(L, -1) != 0) {  // Check if we got a valid index
-            auto _index = static_cast<unsigned>(lua_tonumber(L, -1));
+    static int method_get(lua_State* L, T* obj, const PropertyType& property) {
+        lua_settop(L, 0);
+        return (obj->*(property.getter))(L);
+    }
 
-            T** obj = static_cast<T**>(lua_touserdata(L, 1));
+    /**
+     * @brief Calls property setter method, with value as only argument (internal)
+     *
+     * @param L Lua State
+     * @param obj Object
+     * @param property Property
+     * @return int
+     */
+    static int method_set(lua_State* L, T* obj, const PropertyType& property) {
+        lua_replace(L, 1);
+        lua_settop(L, 1);
+        return (obj->*(property.setter))(L);
+    }
 
-            if (!obj || !*obj) {
-                luaL_error(L, "Internal error, no object given!");
-                return 0;
-            }
+    /**
+     * @brief Pushes typed data member (internal)
+     *
+     * @tparam U Data member type
+     * @param L Lua State
+     * @param obj Object
+     * @param property Property
+     * @return int
+     */
+    template <typename U>
+    static int member_get(lua_State* L, T* obj, const PropertyType& property) {
+        Stack::PushValue(L, obj->*reinterpret_cast<U T::*>(property.member));
+        return 1;
+    }
 
-            if ((_index >> 8u) != 0u) {  // Try to set a func
-                char c[128];
-#if !defined(__MINGW32__) && (defined(_WIN32) || defined(__WIN32__) || defined(WIN32))
-                sprintf_s(c, "Moon: Trying to set the method [%s] of class [%s]", (*obj)->T::Binding.GetMethods()[_index ^ (1u << 8u)].name,
-                          T::Binding.GetName());
-#else
-                sprintf(c, "Moon: Trying to set the method [%s] of class [%s]", (*obj)->T::Binding.GetMethods()[_index ^ (1u << 8u)].name,
-                        T::Binding.GetName());
-#endif
-                luaL_error(L, c);
-                return 0;
-            }
+    /**
+     * @brief Sets typed data member from value at top of stack (internal)
+     *
+     * @tparam U Data member type
+     * @param L Lua State
+     * @param obj Object
+     * @param property Property
+     * @return int
+     */
+    template <typename U>
+    static int member_set(lua_State* L, T* obj, const PropertyType& property) {
+        if constexpr (std::is_const_v<U>) {
+            return luaL_error(L, "Moon: Trying to set the read only property [%s] of class [%s]", property.name, T::Binding.GetName());
+        } else {
+            obj->*reinterpret_cast<U T::*>(property.member) = Stack::GetValue<std::decay_t<U>>(L, -1);
+            return 0;
+        }
+    }
 
-            lua_pop(L, 2);     // Pop metatable and _index
-            lua_remove(L, 1);  // Remove userdata
-            lua_remove(L, 1);  // Remove [key]
+    /**
+     * @brief Pushes data member known at compile time (internal)
+     *
+     * @tparam member Data member pointer
+     * @param L Lua State
+     * @param obj Object
+     * @return int
+     */
+    template <auto member>
+    static int bound_member_get(lua_State* L, T* obj, const PropertyType&) {
+        Stack::PushValue(L, obj->*member);
+        return 1;
+    }
 
-            return ((*obj)->*(T::Binding.GetProperties()[_index].setter))(L);
+    /**
+     * @brief Sets data member known at compile time from value at top of stack (internal)
+     *
+     * @tparam member Data member pointer
+     * @param L Lua State
+     * @param obj Object
+     * @param property Property
+     * @return int
+     */
+    template <auto member>
+    static int bound_member_set(lua_State* L, T* obj, const PropertyType& property) {
+        using U = std::remove_reference_t<decltype(obj->*member)>;
+        if constexpr (std::is_const_v<U>) {
+            return luaL_error(L, "Moon: Trying to set the read only property [%s] of class [%s]", property.name, T::Binding.GetName());
+        } else {
+            obj->*member = Stack::GetValue<std::decay_t<U>>(L, -1);
+            return 0;
         }
-
-        return 0;
     }
 
     /**
      * @brief function_dispatch (internal)
+     * Upvalues are method index and class metatable, respectively. Object is expected as first argument, removed before calling method.
      *
      * @param L Lua State
      * @return int
      */
     static int function_dispatch(lua_State* L) {
-        int i = (int)lua_tonumber(L, lua_upvalueindex(1));
-        T** obj = static_cast<T**>(lua_touserdata(L, lua_upvalueindex(2)));
+        T* obj = self(L);
+        auto i = (size_t)lua_tointeger(L, lua_upvalueindex(1));
+        lua_remove(L, 1);
+
+        auto sample = Profiler::Begin(L);
+        int results = (obj->*(T::Binding.GetMethods()[i].func))(L);
+        Profiler::End(L, lua_upvalueindex(3), sample);
+        return results;
+    }
+
+    /**
+     * @brief Typed method dispatch (internal)
+     * Same upvalues as function_dispatch. Arguments are read right after the object, with no stack shifts.
+     *
+     * @tparam M Member function pointer type
+     * @param L Lua State
+     * @return int
+     */
+    template <typename M>
+    static int method_dispatch(lua_State* L) {
+        T* obj = self(L);
+        auto i = (size_t)lua_tointeger(L, lua_upvalueindex(1));
+        auto method = reinterpret_cast<M>(T::Binding.GetMethods()[i].method);
+        using traits = meta::function_traits<M>;
 
-        return ((*obj)->*(T::Binding.GetMethods()[i].func))(L);
+        auto sample = Profiler::Begin(L);
+        int results = invokeMethod<typename traits::return_type>(std::make_index_sequence<std::tuple_size_v<typename traits::arguments>>{},
+                                                                 obj, method, L, static_cast<typename traits::arguments*>(nullptr));
+        Profiler::End(L, lua_upvalueindex(3), sample);
+        return results;
+    }
+
+    /**
+     * @brief Dispatch of a Lua aware method known at compile time (internal)
+     * Same upvalues as function_dispatch, but method is a template argument instead of being looked up by index.
+     *
+     * @tparam method Member function pointer
+     * @param L Lua State
+     * @return int
+     */
+    template <auto method>
+    static int bound_function_dispatch(lua_State* L) {
+        T* obj = self(L);
+        lua_remove(L, 1);
+
+        auto sample = Profiler::Begin(L);
+        int results = (obj->*method)(L);
+        Profiler::End(L, lua_upvalueindex(3), sample);
+        return results;
+    }
+
+    /**
+     * @brief Typed method dispatch for a method known at compile time (internal)
+     * Same upvalues as function_dispatch, but method is a template argument instead of being looked up by index.
+     *
+     * @tparam method Member function pointer
+     * @param L Lua State
+     * @return int
+     */
+    template <auto method>
+    static int bound_method_dispatch(lua_State* L) {
+        T* obj = self(L);
+        using traits = meta::function_traits<decltype(method)>;
+
+        auto sample = Profiler::Begin(L);
+        int results = invokeMethod<typename traits::return_type>(std::make_index_sequence<std::tuple_size_v<typename traits::arguments>>{},
+                                                                 obj, method, L, static_cast<typename traits::arguments*>(nullptr));
+        Profiler::End(L, lua_upvalueindex(3), sample);
+        return results;
+    }
+
+    template <typename Ret, size_t... indices, typename M, typename... Args>
+    static inline int invokeMethod(std::index_sequence<indices...>, T* obj, M method, lua_State* L, std::tuple<Args...>*) {
+        if constexpr (std::is_void_v<Ret>) {
+            (obj->*method)(Stack::GetValue<std::decay_t<Args>>(L, indices + 2)...);
+            return 0;
+        } else {
+            Stack::PushValue(L, (obj->*method)(Stack::GetValue<std::decay_t<Args>>(L, indices + 2)...));
+            return meta::count_expected_v<Ret>;
+        }
+    }
+
+    /**
+     * @brief Statistics of a property accessor, from upvalue 3 of property_getter and property_setter (internal)
+     * Upvalue only exists when instrumentation is enabled.
+     *
+     * @param L Lua State
+     * @param index Twice the property index, plus one for setters
+     * @return CallStats*
+     */
+    static inline CallStats* propertyStats(lua_State* L, size_t index) {
+        if constexpr (Profiler::s_enabled) {
+            return static_cast<CallStats**>(lua_touserdata(L, lua_upvalueindex(3)))[index];
+        } else {
+            return nullptr;
+        }
+    }
+
+    /**
+     * @brief Validates and retrieves object passed as first argument to a method, against class metatable in upvalue 2 (internal)
+     *
+     * @param L Lua State
+     * @return T*
+     */
+    static T* self(lua_State* L) {
+        T** obj = static_cast<T**>(lua_touserdata(L, 1));
+        if (obj == nullptr || !lua_getmetatable(L, 1) || !lua_rawequal(L, -1, lua_upvalueindex(2))) {
+            luaL_error(L, "Moon: method of class [%s] must be called with an object, use ':'", T::Binding.GetName());
+            return nullptr;
+        }
+        lua_pop(L, 1);
+        return *obj;
     }
 
     /**
@@ -253,10 +807,22 @@ private:
      * @return int
      */
     static int gc_obj(lua_State* L) {
-        T** obj = static_cast<T**>(lua_touserdata(L, -1));
+        T** obj = static_cast<T**>(lua_touserdata(L, 1));
 
         if (obj && *obj) {
-            delete (*obj);
+            if (lua_getiuservalue(L, 1, 1) == LUA_TNUMBER) {  // Storage kind or ownership chosen when pushed
+                lua_Integer tag = lua_tointeger(L, -1);
+                if (tag == s_inlineTag) {
+                    (*obj)->~T();  // Storage is owned by Lua
+                } else if (tag == (lua_Integer)Ownership::Owned) {
+                    delete (*obj);
+                } else if (tag == (lua_Integer)Ownership::Shared) {
+                    sharedAddress(obj)->~shared_ptr();
+                }
+            } else if (T::Binding.GetGC()) {
+                delete (*obj);
+            }
+            *obj = nullptr;
         }
 
         return 0;
@@ -292,48 +858,179 @@ private:
     }
 };
 
+/// Methods and properties of a class, built at compile time by MakeBindingTable.
+/// \tparam T Class to expose to Lua.
+/// \tparam methodCount Number of methods.
+/// \tparam propertyCount Number of properties.
+template <class T, size_t methodCount, size_t propertyCount>
+struct BindingTable {
+    std::array<typename LuaClass<T>::FunctionType, methodCount> methods{};
+    std::array<typename LuaClass<T>::PropertyType, propertyCount> properties{};
+    /// Methods as a null terminated list of dispatchers, for a single luaL_setfuncs pass.
+    std::array<luaL_Reg, methodCount + 1> functions{};
+    /// Whether or not some method is dispatched by index, which rules out a single pass.
+    bool indexed{false};
+};
+
+/// Sorts methods and properties, in any order, into a binding table. Usable in constant expressions.
+/// \tparam T Class to expose to Lua.
+/// \tparam Entries Methods and properties types.
+/// \param entries Methods and properties, e.g. from LuaClass<T>::MakeMethod and LuaClass<T>::MakeProperty.
+/// \return Binding table.
+template <class T, typename... Entries>
+constexpr auto MakeBindingTable(Entries... entries) {
+    using FunctionType = typename LuaClass<T>::FunctionType;
+    constexpr size_t methodCount = (size_t{std::is_same_v<Entries, FunctionType>} + ... + 0);
+    BindingTable<T, methodCount, sizeof...(Entries) - methodCount> table{};
+    size_t method = 0;
+    size_t property = 0;
+    auto add = [&](auto entry) {
+        if constexpr (std::is_same_v<decltype(entry), FunctionType>) {
+            table.functions[method] = {entry.name, entry.dispatch};
+            table.indexed = table.indexed || entry.indexed;
+            table.methods[method++] = entry;
+        } else {
+            table.properties[property++] = entry;
+        }
+    };
+    (add(entries), ...);
+    return table;
+}
+
 template <class BindableClass>
 class Binding {
 public:
     using LuaFunction = typename LuaClass<BindableClass>::FunctionType;
     using LuaProperty = typename LuaClass<BindableClass>::PropertyType;
 
+    /// Read only list of methods or properties, over binding own list or over a binding table.
+    template <typename Entry>
+    class Entries {
+    public:
+        Entries(const Entry* data, size_t size) : m_data(data), m_size(size) {}
+
+        [[nodiscard]] inline size_t size() const { return m_size; }
+
+        [[nodiscard]] inline bool empty() const { return m_size == 0; }
+
+        inline const Entry& operator[](size_t index) const { return m_data[index]; }
+
+        [[nodiscard]] inline const Entry* begin() const { return m_data; }
+
+        [[nodiscard]] inline const Entry* end() const { return m_data + m_size; }
+
+    private:
+        const Entry* m_data;
+        size_t m_size;
+    };
+
     explicit Binding(const char* name) : m_name(name) {}
 
+    /// Creates binding over a table of entries built at compile time, e.g. by MOON_DEFINE_BINDING_TABLE. Entries are used in place, so
+    /// table must have static storage. They are only copied if methods or properties are added afterwards.
+    template <size_t methods, size_t properties>
+    Binding(const char* name, const BindingTable<BindableClass, methods, properties>& table)
+        : m_name(name),
+          m_methodTable(table.methods.data()),
+          m_methodCount(methods),
+          m_propertyTable(table.properties.data()),
+          m_propertyCount(properties),
+          m_functions(table.indexed ? nullptr : table.functions.data()) {}
+
     ~Binding() = default;
 
     [[nodiscard]] inline const char* GetName() const { return m_name; }
 
-    [[nodiscard]] inline const auto& GetMethods() const { return m_methods; }
+    [[nodiscard]] inline Entries<LuaFunction> GetMethods() const {
+        return m_methodTable != nullptr ? Entries<LuaFunction>{m_methodTable, m_methodCount}
+                                        : Entries<LuaFunction>{m_methods.data(), m_methods.size()};
+    }
+
+    [[nodiscard]] inline Entries<LuaProperty> GetProperties() const {
+        return m_propertyTable != nullptr ? Entries<LuaProperty>{m_propertyTable, m_propertyCount}
+                                          : Entries<LuaProperty>{m_properties.data(), m_properties.size()};
+    }
 
-    [[nodiscard]] inline const auto& GetProperties() const { return m_properties; }
+    /// Getter for methods as a null terminated luaL_Reg list, to register them in a single pass.
+    /// \return Methods list. Null unless binding was built from a table of methods known at compile time.
+    [[nodiscard]] inline const luaL_Reg* GetFunctions() const { return m_functions; }
 
     [[nodiscard]] inline bool GetGC() const { return m_gc; }
 
+    [[nodiscard]] inline bool GetInline() const { return m_inline; }
+
+    [[nodiscard]] inline bool GetLazy() const { return m_lazy; }
+
     Binding& RemoveGC() {
         m_gc = false;
         return *this;
     }
 
+    /// Objects constructed from Lua are stored directly in their userdata, instead of heap allocated. Their destructor is called when
+    /// collected, even if GC was removed, since their storage is owned by Lua. Pointers pushed from C++ are not affected.
+    Binding& InlineStorage() {
+        m_inline = true;
+        return *this;
+    }
+
+    /// Class metatable is created in each state when first object is constructed or pushed, instead of when class is registered. Keeps
+    /// state creation cheap when many classes are registered but few are used.
+    Binding& LazyRegistration() {
+        m_lazy = true;
+        return *this;
+    }
+
     Binding& AddMethod(LuaFunction func) {
+        detach();
         m_methods.push_back(func);
         return *this;
     }
 
+    /// Adds a method from a member function pointer, e.g. `&T::foo`. Arguments and return are converted at compile time.
+    template <typename M>
+    Binding& AddMethod(const char* name, M method) {
+        detach();
+        m_methods.push_back(LuaClass<BindableClass>::MakeMethod(name, method));
+        return *this;
+    }
+
     Binding& AddProperty(LuaProperty prop) {
+        detach();
         m_properties.push_back(prop);
         return *this;
     }
 
+    /// Adds a property from a data member pointer, e.g. `&T::x`. Value is converted at compile time.
+    template <typename U>
+    Binding& AddProperty(const char* name, U BindableClass::*member) {
+        detach();
+        m_properties.push_back(LuaClass<BindableClass>::MakeProperty(name, member));
+        return *this;
+    }
+
 private:
+    /// Copies table entries to own lists, before adding to them.
+    void detach() {
+        if (m_methodTable != nullptr) {
+            m_methods.assign(m_methodTable, m_methodTable + m_methodCount);
+            m_properties.assign(m_propertyTable, m_propertyTable + m_propertyCount);
+            m_methodTable = nullptr;
+            m_propertyTable = nullptr;
+            m_functions = nullptr;
+        }
+    }
+
     const char* m_name;
     std::vector<LuaFunction> m_methods;
     std::vector<LuaProperty> m_properties;
+    /// Entries of binding table, if built from one.
+    const LuaFunction* m_methodTable{nullptr};
+    size_t m_methodCount{0};
+    const LuaProperty* m_propertyTable{nullptr};
+    size_t m_propertyCount{0};
+    const luaL_Reg* m_functions{nullptr};
     bool m_gc{true};
+    bool m_inline{false};
+    bool m_lazy{false};
 };
-
-namespace meta {
-template <typename T, typename Ret = T>
-using is_binding_t = std::enable_if_t<std::is_same_v<decltype(T::Binding), Binding<T>>, Ret>;
-}
 }  // namespace moon
@@ -11,19 +11,19 @@ public:
 
     explicit UserDefinedType(int prop) : m_prop(prop) {}
 
-    explicit UserDefinedType(lua_State*) : m_prop(Moon::Get<int>(1)) {}
+    explicit UserDefinedType(lua_State* L) : m_prop(moon::Core::Get<int>(L, 1)) {}
 
     MOON_DECLARE_CLASS(UserDefinedType)
 
     MOON_PROPERTY(m_prop)
 
     MOON_METHOD(Getter) {
-        Moon::Push(m_prop + Moon::Get<int>(1));
+        moon::Core::Push(L, m_prop + moon::Core::Get<int>(L, 1));
         return 1;
     }
 
     MOON_METHOD(Setter) {
-        s_testClass = m_prop = Moon::Get<int>(1);
+        s_testClass = m_prop = moon::Core::Get<int>(L, 1);
         return 0;
     }
 
@@ -36,4 +36,85 @@ private:
     static int s_testClass;
 };
 
+/// Value type bound with inline storage, counting live instances.
+class UserDefinedValue {
+public:
+    explicit UserDefinedValue(lua_State* L) : m_x(moon::Core::Get<double>(L, 1)), m_y(moon::Core::Get<double>(L, 2)) { ++s_instances; }
+
+    UserDefinedValue(const UserDefinedValue& other) : m_x(other.m_x), m_y(other.m_y) { ++s_instances; }
+
+    ~UserDefinedValue() { --s_instances; }
+
+    MOON_DECLARE_CLASS(UserDefinedValue)
+
+    MOON_PROPERTY(m_x)
+
+    MOON_PROPERTY(m_y)
+
+    [[nodiscard]] inline double Length() const { return m_x + m_y; }
+
+    [[nodiscard]] UserDefinedValue* Self() { return this; }
+
+    static inline int Instances() { return s_instances; }
+
+private:
+    double m_x{0};
+    double m_y{0};
+    static int s_instances;
+};
+
+/// Type bound with typed methods and data members, without Lua aware boilerplate, counting live instances.
+class UserDefinedTyped {
+public:
+    explicit UserDefinedTyped(lua_State* L) : value(moon::Core::Get<int>(L, 1)) { ++s_instances; }
+
+    UserDefinedTyped(const UserDefinedTyped&) = delete;
+
+    ~UserDefinedTyped() { --s_instances; }
+
+    UserDefinedTyped& operator=(const UserDefinedTyped&) = delete;
+
+    MOON_DECLARE_CLASS(UserDefinedTyped)
+
+    [[nodiscard]] int Add(int other) const { return value + other; }
+
+    void Rename(const std::string& newName) { name = newName; }
+
+    [[nodiscard]] std::string Describe(const std::string& prefix) const { return prefix + name; }
+
+    [[nodiscard]] UserDefinedTyped* Self() { return this; }
+
+    static inline int Instances() { return s_instances; }
+
+    int value{0};
+    std::string name{"typed"};
+    const int id{42};
+
+private:
+    static int s_instances;
+};
+
+/// Type bound from a compile time binding table, with lazy registration.
+class UserDefinedTable {
+public:
+    explicit UserDefinedTable(lua_State* L) : m_prop(moon::Core::Get<int>(L, 1)) {}
+
+    MOON_DECLARE_CLASS(UserDefinedTable)
+
+    MOON_PROPERTY(m_prop)
+
+    MOON_METHOD(Double) {
+        moon::Core::Push(L, 2 * m_prop);
+        return 1;
+    }
+
+    [[nodiscard]] int Scale(int factor) const { return m_prop * factor; }
+
+    int count{0};
+    const int id{7};
+
+private:
+    int m_prop{0};
+};
+
 #endif
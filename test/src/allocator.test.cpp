@@ -0,0 +1,51 @@
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+TEST_CASE("states with custom allocators", "[allocator]") {
+    SECTION("default allocator accounts memory") {
+        moon::State state{std::make_unique<moon::Allocator>()};
+        auto* allocator = state.GetAllocator();
+        REQUIRE(allocator != nullptr);
+        size_t usage = allocator->GetUsage();
+        REQUIRE(usage > 0);
+        REQUIRE(state.RunCode("t = {} for i = 1, 1000 do t[i] = tostring(i) end"));
+        REQUIRE(allocator->GetUsage() > usage);
+        REQUIRE(state.RunCode("t = nil collectgarbage()"));
+        REQUIRE(allocator->GetPeak() >= allocator->GetUsage());
+        REQUIRE((size_t)lua_gc(state.GetState(), LUA_GCCOUNT, 0) * 1024 <= allocator->GetUsage());
+    }
+
+    SECTION("pool allocator recycles small blocks") {
+        moon::State state{std::make_unique<moon::PoolAllocator>()};
+        auto* allocator = static_cast<moon::PoolAllocator*>(state.GetAllocator());
+        REQUIRE(allocator->GetChunkCount() > 0);
+        REQUIRE(state.RunCode("for n = 1, 10 do local t = {} for i = 1, 1000 do t[i] = {i, tostring(i)} end end collectgarbage()"));
+        size_t chunks = allocator->GetChunkCount();
+        REQUIRE(state.RunCode("for n = 1, 10 do local t = {} for i = 1, 1000 do t[i] = {i, tostring(i)} end end collectgarbage()"));
+        REQUIRE(allocator->GetChunkCount() == chunks);
+        REQUIRE(state.Call<int>("tonumber", "42") == 42);
+    }
+
+    SECTION("memory limit fails allocations cleanly") {
+        std::string info, warning, error;
+        LoggerSetter logs{info, warning, error};
+        moon::State state{std::make_unique<moon::PoolAllocator>()};
+        auto* allocator = state.GetAllocator();
+        allocator->SetLimit(allocator->GetUsage() + 64 * 1024);
+        REQUIRE_FALSE(state.RunCode("local t = {} for i = 1, 100000 do t[i] = i end"));
+        REQUIRE(error.find("not enough memory") != std::string::npos);
+        REQUIRE(allocator->GetFailures() > 0);
+        REQUIRE(allocator->GetUsage() <= allocator->GetLimit());
+
+        allocator->SetLimit(0);
+        REQUIRE(state.RunCode("local t = {} for i = 1, 100000 do t[i] = i end"));
+    }
+
+    SECTION("facade state with allocator") {
+        Moon::Init(std::make_unique<moon::PoolAllocator>());
+        REQUIRE(Moon::GetDefault().GetAllocator() != nullptr);
+        REQUIRE(Moon::RunCode("assert(1 + 1 == 2)"));
+        Moon::CloseState();
+    }
+}
@@ -0,0 +1,61 @@
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+TEST_CASE("lightweight Lua callbacks", "[callback][function]") {
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    moon::State state;
+    std::vector<moon::Callback<int(int)>> listeners;
+    state.RegisterFunction("Listen", [&listeners](moon::Callback<int(int)> callback) { listeners.emplace_back(std::move(callback)); });
+    REQUIRE(state.RunCode("Listen(function(x) return x + 1 end); Listen(function(x) return x * 2 end)"));
+    REQUIRE(listeners.size() == 2);
+
+    SECTION("calls and copies") {
+        REQUIRE(listeners[0](1) == 2);
+        REQUIRE(listeners[1](3) == 6);
+        auto copy = listeners[0];
+        REQUIRE(copy.GetKey() != listeners[0].GetKey());
+        listeners.clear();
+        state.GC().Collect();
+        REQUIRE(copy(5) == 6);
+        moon::Callback<int(int)> moved{std::move(copy)};
+        REQUIRE_FALSE(copy);
+        REQUIRE(moved(1) == 2);
+        copy = moved;
+        REQUIRE(copy(2) == 3);
+    }
+
+    SECTION("multiple returns and void") {
+        REQUIRE(state.RunCode("function Pair(a) return a, tostring(a) end; function Store(v) stored = v end"));
+        lua_getglobal(state.GetState(), "Pair");
+        auto pair = moon::Callback<std::tuple<int, std::string>(int)>::CreateAndPop(state.GetState());
+        REQUIRE(pair(7) == std::make_tuple(7, std::string{"7"}));
+        auto store = state.Get<moon::Callback<void(bool)>>("Store");
+        store(true);
+        REQUIRE(state.Get<bool>("stored"));
+    }
+
+    SECTION("protected errors are logged") {
+        REQUIRE(state.RunCode("function Fail() error('failed on purpose') end"));
+        auto fail = state.Get<moon::Callback<int()>>("Fail");
+        REQUIRE(fail() == 0);
+        REQUIRE(error.find("failed on purpose") != std::string::npos);
+        logs.Clear();
+        moon::Callback<void()> empty;
+        empty();
+        REQUIRE(logs.ErrorCheck());
+    }
+
+    SECTION("unprotected errors propagate to Lua") {
+        REQUIRE(state.RunCode("function Fail() error('failed on purpose') end"));
+        auto fail = state.Get<moon::Callback<void()>>("Fail");
+        fail.SetMode(moon::CallbackMode::Unprotected);
+        state.RegisterFunction("Fire", [&fail]() { fail(); });
+        REQUIRE(state.RunCode("local ok, err = pcall(Fire); assert(not ok and err:find('failed on purpose'))"));
+    }
+
+    REQUIRE(state.GetTop() == 0);
+    INFO(logs.GetError())
+    REQUIRE(logs.NoErrors());
+}
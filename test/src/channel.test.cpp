@@ -0,0 +1,118 @@
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+TEST_CASE("bounded channel of encoded messages", "[channel]") {
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    moon::Channel channel{2};
+    REQUIRE(channel.GetCapacity() == 2);
+
+    std::vector<uint8_t> message{1, 2, 3};
+    REQUIRE(channel.TrySend(message));
+    REQUIRE(message.empty());
+    message = {4};
+    REQUIRE(channel.Send(message));
+    message = {5};
+    REQUIRE_FALSE(channel.TrySend(message));
+    REQUIRE(message == std::vector<uint8_t>{5});
+    REQUIRE(channel.GetSize() == 2);
+    REQUIRE_FALSE(channel.CanSend());
+
+    std::vector<uint8_t> received;
+    REQUIRE(channel.TryReceive(received));
+    REQUIRE(received == std::vector<uint8_t>{1, 2, 3});
+    REQUIRE(channel.TrySend(message));
+
+    channel.Close();
+    REQUIRE(channel.IsClosed());
+    REQUIRE_FALSE(channel.Send(message));
+    REQUIRE(channel.Receive(received));
+    REQUIRE(received == std::vector<uint8_t>{4});
+    REQUIRE(channel.Receive(received));
+    REQUIRE(received == std::vector<uint8_t>{5});
+    REQUIRE_FALSE(channel.Receive(received));
+    REQUIRE(channel.CanReceive());
+    REQUIRE(logs.NoErrors());
+}
+
+TEST_CASE("channel carries Lua values between states", "[channel]") {
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    auto channel = std::make_shared<moon::Channel>(4);
+    moon::State producer;
+    moon::State consumer;
+    moon::Channel::Push(producer.GetState(), channel);
+    lua_setglobal(producer.GetState(), "jobs");
+    moon::Channel::Push(consumer.GetState(), channel);
+    lua_setglobal(consumer.GetState(), "jobs");
+
+    SECTION("from Lua to Lua") {
+        REQUIRE(producer.RunCode("assert(jobs:Send({id = 1, tags = {'a', 'b'}})); assert(jobs:TrySend(2.5)); assert(#jobs == 2)"));
+        REQUIRE(consumer.RunCode(R"(
+            local ok, job = jobs:TryReceive()
+            assert(ok and job.id == 1 and job.tags[2] == 'b')
+            ok, job = jobs:Receive()
+            assert(ok and math.type(job) == 'float')
+            assert(not jobs:TryReceive())
+        )"));
+    }
+
+    SECTION("from C++ to Lua and back") {
+        lua_State* L = producer.GetState();
+        lua_pushstring(L, "hello");
+        REQUIRE(channel->Send(L, -1));
+        lua_pop(L, 1);
+        REQUIRE(consumer.RunCode("local ok, value = jobs:Receive(); assert(value == 'hello'); jobs:Send(#value)"));
+        REQUIRE(channel->Receive(L));
+        REQUIRE(producer.Get<int>(-1) == 5);
+        lua_pop(L, 1);
+        REQUIRE(moon::Channel::Get(L, 1) == nullptr);
+        REQUIRE_FALSE(logs.NoErrors());
+        logs.Clear();
+    }
+
+    SECTION("between threads") {
+        std::thread worker{[channel]() {
+            moon::State state;
+            moon::Channel::Push(state.GetState(), channel);
+            lua_setglobal(state.GetState(), "jobs");
+            state.RunCode("for i = 1, 100 do jobs:Send(i) end; jobs:Close()");
+        }};
+        REQUIRE(consumer.RunCode("total = 0; while true do local ok, value = jobs:Receive(); if not ok then break end; total = total + value end"));
+        worker.join();
+        REQUIRE(consumer.Get<int>("total") == 5050);
+    }
+
+    INFO(logs.GetError())
+    REQUIRE(logs.NoErrors());
+}
+
+TEST_CASE("channel yields coroutines instead of blocking", "[channel][coroutine]") {
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    auto channel = std::make_shared<moon::Channel>(1);
+    moon::State state;
+    moon::Channel::Push(state.GetState(), channel);
+    lua_setglobal(state.GetState(), "jobs");
+    REQUIRE(state.RunCode(R"(
+        received = {}
+        function Consumer() while true do local ok, value = jobs:Receive(); if not ok then return end; received[#received + 1] = value end end
+        function Producer() for i = 1, 3 do jobs:Send(i * 10) end end
+    )"));
+
+    moon::Scheduler scheduler{state.GetState()};
+    REQUIRE(scheduler.Spawn(state.MakeCoroutine("Consumer")));
+    REQUIRE(scheduler.Update() == 1);
+    REQUIRE(scheduler.Spawn(state.MakeCoroutine("Producer")));
+    for (int i = 0; i < 10; ++i) {
+        scheduler.Update();
+    }
+    REQUIRE(scheduler.GetSize() == 1);
+    REQUIRE(state.RunCode("assert(#received == 3 and received[3] == 30)"));
+    channel->Close();
+    scheduler.Run();
+    REQUIRE(scheduler.GetSize() == 0);
+    INFO(logs.GetError())
+    REQUIRE(logs.NoErrors());
+}
@@ -0,0 +1,102 @@
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+SCENARIO("compiled Lua chunks", "[chunk][basic]") {
+    Moon::Init();
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    BEGIN_STACK_GUARD
+
+    GIVEN("a compiled code snippet") {
+        REQUIRE(Moon::RunCode("counter = 0"));
+        auto chunk = Moon::CompileCode("counter = counter + 1; return counter");
+        REQUIRE(chunk.IsLoaded());
+        REQUIRE(chunk.GetState() == Moon::GetState());
+        REQUIRE(Moon::Get<int>("counter") == 0);
+
+        WHEN("chunk is ran multiple times") {
+            REQUIRE(chunk.Run(0));
+            REQUIRE(chunk.Run(0));
+            REQUIRE(chunk.Run(1));
+
+            THEN("results should be left in stack") {
+                REQUIRE(Moon::Get<int>(-1) == 3);
+                Moon::Pop();
+            }
+        }
+
+        WHEN("chunk is dumped to bytecode") {
+            auto bytecode = chunk.Dump();
+            REQUIRE_FALSE(bytecode.empty());
+
+            THEN("bytecode can be loaded in another state") {
+                moon::State other;
+                other.Set("counter", 10);
+                auto loaded = moon::Chunk::FromBytecode(other.GetState(), bytecode);
+                REQUIRE(loaded.IsLoaded());
+                REQUIRE(loaded.Run(0));
+                REQUIRE(other.Get<int>("counter") == 11);
+            }
+
+            AND_THEN("bytecode is refused as source code") {
+                auto loaded = moon::Chunk::FromCode(Moon::GetState(), "return 1");
+                REQUIRE(loaded.IsLoaded());
+                auto refused = moon::Chunk::FromBuffer(Moon::GetState(), bytecode.data(), bytecode.size(), "=refused", "t");
+                REQUIRE_FALSE(refused.IsLoaded());
+                REQUIRE(logs.ErrorCheck());
+            }
+        }
+    }
+
+    GIVEN("invalid code") {
+        auto chunk = Moon::CompileCode("a =");
+
+        THEN("chunk should not be loaded and error logged") {
+            REQUIRE_FALSE(chunk.IsLoaded());
+            REQUIRE(logs.ErrorCheck());
+            REQUIRE_FALSE(chunk.Run());
+            REQUIRE(logs.ErrorCheck());
+            REQUIRE(chunk.Dump().empty());
+        }
+    }
+
+    GIVEN("a chunk cache") {
+        auto& cache = Moon::GetDefault().GetChunkCache();
+        cache.Clear();
+
+        WHEN("same code is ran multiple times") {
+            REQUIRE(Moon::RunCachedCode("cached = (cached or 0) + 1"));
+            REQUIRE(Moon::RunCachedCode("cached = (cached or 0) + 1"));
+
+            THEN("code should be compiled once") {
+                REQUIRE(Moon::Get<int>("cached") == 2);
+                REQUIRE(cache.GetSize() == 1);
+                REQUIRE(cache.GetCode("cached = (cached or 0) + 1") == cache.GetCode("cached = (cached or 0) + 1"));
+            }
+        }
+
+        WHEN("files are loaded") {
+            REQUIRE(Moon::LoadCachedFile("scripts/passed.lua"));
+            REQUIRE(Moon::LoadCachedFile("scripts/passed.lua"));
+            REQUIRE_FALSE(Moon::LoadCachedFile("scripts/failed.lua"));
+            REQUIRE(logs.ErrorCheck());
+            REQUIRE_FALSE(Moon::LoadCachedFile("scripts/missing.lua"));
+            REQUIRE(logs.ErrorCheck());
+
+            THEN("only valid files should be cached") { REQUIRE(cache.GetSize() == 1); }
+        }
+
+        WHEN("code fails to compile") {
+            REQUIRE_FALSE(Moon::RunCachedCode("a ="));
+            REQUIRE(logs.ErrorCheck());
+
+            THEN("nothing should be cached") { REQUIRE(cache.GetSize() == 0); }
+        }
+    }
+
+    END_STACK_GUARD
+    INFO(logs.GetError())
+    REQUIRE(logs.NoErrors());
+    Moon::CloseState();
+}
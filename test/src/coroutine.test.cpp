@@ -0,0 +1,88 @@
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+TEST_CASE("resume and yield coroutines", "[coroutine]") {
+    Moon::Init();
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    BEGIN_STACK_GUARD
+    REQUIRE(Moon::RunCode(R"(
+        function Counter(start)
+            local value = start
+            while value < start + 2 do
+                local step = coroutine.yield(value)
+                value = value + step
+            end
+            return value, 'done'
+        end
+        function Fail() coroutine.yield(); error('failed on purpose') end
+    )"));
+
+    SECTION("values are passed through resume and yield") {
+        auto counter = Moon::MakeCoroutine("Counter");
+        REQUIRE(counter.IsLoaded());
+        REQUIRE(counter.Resume(10) == moon::CoroutineStatus::Suspended);
+        REQUIRE(counter.GetResult<int>() == 10);
+        REQUIRE(counter.Resume(1) == moon::CoroutineStatus::Suspended);
+        REQUIRE(counter.GetResult<int>() == 11);
+        REQUIRE(counter.Resume(1) == moon::CoroutineStatus::Finished);
+        auto [value, status] = counter.GetResult<std::tuple<int, std::string>>();
+        REQUIRE(value == 12);
+        REQUIRE(status == "done");
+        REQUIRE(counter.IsDone());
+        counter.Resume();
+        REQUIRE(logs.ErrorCheck());
+    }
+
+    SECTION("errors are logged") {
+        auto fail = Moon::MakeCoroutine("Fail");
+        REQUIRE(fail.Resume() == moon::CoroutineStatus::Suspended);
+        REQUIRE(fail.Resume() == moon::CoroutineStatus::Error);
+        REQUIRE(error.find("failed on purpose") != std::string::npos);
+        error.clear();
+        auto missing = Moon::MakeCoroutine("Missing");
+        REQUIRE(logs.ErrorCheck());
+        REQUIRE(missing.IsDone());
+    }
+
+    END_STACK_GUARD
+    Moon::CloseState();
+}
+
+TEST_CASE("schedule coroutines cooperatively", "[coroutine]") {
+    Moon::Init();
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    BEGIN_STACK_GUARD
+    bool ready = false;
+    Moon::RegisterFunction("Await", [&ready]() { return moon::Yield{[&ready]() { return ready; }}; });
+    Moon::RegisterFunction("Pass", []() { return moon::Yield{}; });
+    REQUIRE(Moon::RunCode(R"(
+        finished = 0
+        function Session() Pass(); Pass(); finished = finished + 1 end
+        function Waiting() Await(); finished = finished + 10 end
+    )"));
+
+    moon::Scheduler scheduler{Moon::GetState()};
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(scheduler.Spawn(Moon::MakeCoroutine("Session")));
+    }
+    REQUIRE(scheduler.Spawn(Moon::MakeCoroutine("Waiting")));
+    REQUIRE(scheduler.GetSize() == 101);
+
+    REQUIRE(scheduler.Update() == 101);
+    REQUIRE(scheduler.Update() == 1);
+    REQUIRE(Moon::Get<int>("finished") == 100);
+    REQUIRE(scheduler.Update() == 1);
+
+    ready = true;
+    scheduler.Run();
+    REQUIRE(scheduler.GetSize() == 0);
+    REQUIRE(Moon::Get<int>("finished") == 110);
+
+    END_STACK_GUARD
+    INFO(logs.GetError())
+    REQUIRE(logs.NoErrors());
+    Moon::CloseState();
+}
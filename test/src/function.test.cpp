@@ -0,0 +1,58 @@
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+TEST_CASE("cached Lua function handles", "[functions]") {
+    Moon::Init();
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    BEGIN_STACK_GUARD
+    REQUIRE(Moon::RunCode(R"(
+        calls = 0
+        function Add(a, b) calls = calls + 1; return a + b end
+        function Split(s) return s:sub(1, 1), #s end
+        function Fail() error("failed on purpose") end
+        handlers = {OnEvent = function(name) last = name end}
+    )"));
+
+    SECTION("functions are called with typed arguments and results") {
+        auto add = Moon::MakeFunction<int(int, int)>("Add");
+        REQUIRE(add.IsLoaded());
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(add(i, 1) == i + 1);
+        }
+        REQUIRE(Moon::Get<int>("calls") == 100);
+
+        auto split = Moon::MakeFunction<std::tuple<std::string, int>(const std::string&)>("Split");
+        auto [head, size] = split("moon");
+        REQUIRE(head == "m");
+        REQUIRE(size == 4);
+
+        auto onEvent = Moon::MakeFunction<void(const char*)>("handlers", "OnEvent");
+        onEvent("started");
+        REQUIRE(Moon::Get<std::string>("last") == "started");
+    }
+
+    SECTION("handles survive global being replaced") {
+        auto add = Moon::MakeFunction<int(int, int)>("Add");
+        REQUIRE(Moon::RunCode("Add = nil; collectgarbage()"));
+        REQUIRE(add(1, 2) == 3);
+    }
+
+    SECTION("errors are logged with traceback") {
+        auto fail = Moon::MakeFunction<int()>("Fail");
+        REQUIRE(fail() == 0);
+        REQUIRE(error.find("failed on purpose") != std::string::npos);
+        REQUIRE(error.find("stack traceback") != std::string::npos);
+        error.clear();
+
+        auto missing = Moon::MakeFunction<void()>("Missing");
+        REQUIRE_FALSE(missing.IsLoaded());
+        REQUIRE(logs.ErrorCheck());
+        missing();
+        REQUIRE(logs.ErrorCheck());
+    }
+
+    END_STACK_GUARD
+    Moon::CloseState();
+}
@@ -127,6 +127,48 @@ TEST_CASE("register C++ functions, lambdas as global lua functions", "[functions
     Moon::CloseState();
 }
 
+int TestCPPPlainFunction(int a, int b) { return a * b; }
+
+TEST_CASE("register C++ functions as C closures", "[functions][basic]") {
+    Moon::Init();
+
+    BEGIN_STACK_GUARD
+
+    SECTION("register compile time functions without upvalues") {
+        Moon::RegisterFunction<&TestCPPPlainFunction>("TestCPPPlainFunction");
+        REQUIRE(Moon::RunCode("assert(TestCPPPlainFunction(2, 3) == 6)"));
+        Moon::RegisterFunction<&Test::TestCPPStaticFunction>("TestCPPStaticFunction");
+        REQUIRE(Moon::RunCode("assert(TestCPPStaticFunction(true) == 'passed')"));
+        REQUIRE(Moon::GetType("TestCPPPlainFunction") == moon::LuaType::Function);
+    }
+
+    SECTION("stateful functors are stored in place and destroyed when collected") {
+        auto counter = std::make_shared<int>(0);
+        Moon::RegisterFunction("Increment", [counter](int value) { return *counter += value; });
+        REQUIRE(counter.use_count() == 2);
+        REQUIRE(Moon::RunCode("Increment(2); assert(Increment(3) == 5)"));
+        REQUIRE(*counter == 5);
+        Moon::Clean("Increment");
+        lua_gc(Moon::GetState(), LUA_GCCOLLECT, 0);
+        REQUIRE(counter.use_count() == 1);
+    }
+
+    SECTION("mutable lambdas keep their state between calls") {
+        Moon::RegisterFunction("Next", [count = 0]() mutable { return ++count; });
+        REQUIRE(Moon::RunCode("Next(); Next(); assert(Next() == 3)"));
+    }
+
+    SECTION("stl functions can be registered") {
+        std::function<std::string(std::string)> echo = [](std::string value) { return value; };
+        Moon::RegisterFunction("Echo", echo);
+        REQUIRE(Moon::RunCode("assert(Echo('passed') == 'passed')"));
+    }
+
+    END_STACK_GUARD
+
+    Moon::CloseState();
+}
+
 SCENARIO("get lua function as C++ stl function", "[functions]") {
     Moon::Init();
     std::string log;
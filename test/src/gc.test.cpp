@@ -0,0 +1,49 @@
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+TEST_CASE("control garbage collector", "[gc]") {
+    Moon::Init();
+    auto gc = Moon::GC();
+    BEGIN_STACK_GUARD
+
+    SECTION("modes and parameters") {
+        REQUIRE(gc.SetGenerational() == moon::GCMode::Incremental);
+        REQUIRE(gc.SetIncremental(200, 100) == moon::GCMode::Generational);
+        REQUIRE(gc.SetPause(150) == 200);
+        REQUIRE(gc.SetPause(200) == 150);
+        REQUIRE(gc.SetStepMultiplier(100) == 100);
+    }
+
+    SECTION("stop, restart and collect") {
+        gc.Stop();
+        REQUIRE_FALSE(gc.IsRunning());
+        REQUIRE(Moon::RunCode("t = {} for i = 1, 10000 do t[i] = {} end"));
+        size_t heap = gc.GetHeapSize();
+        REQUIRE(Moon::RunCode("t = nil"));
+        size_t cycles = gc.GetCycles();
+        gc.Collect();
+        REQUIRE(gc.GetHeapSize() < heap);
+        REQUIRE(gc.GetCycles() == cycles + 1);
+        gc.Restart();
+        REQUIRE(gc.IsRunning());
+    }
+
+    SECTION("bounded steps") {
+        gc.Stop();
+        REQUIRE(Moon::RunCode("for i = 1, 10000 do local t = {} end"));
+        size_t cycles = gc.GetCycles();
+        while (!gc.Step(1)) {
+        }
+        REQUIRE(gc.GetCycles() > cycles);
+        REQUIRE(Moon::RunCode("for i = 1, 10000 do local t = {} end"));
+        cycles = gc.GetCycles();
+        while (!gc.StepFor(std::chrono::microseconds{100})) {
+        }
+        REQUIRE(gc.GetCycles() > cycles);
+        gc.Restart();
+    }
+
+    END_STACK_GUARD
+    Moon::CloseState();
+}
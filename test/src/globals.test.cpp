@@ -264,16 +264,18 @@ SCENARIO("push global values to Lua stack", "[basic][global]") {
                 REQUIRE(Moon::Get<std::map<std::string, int>>("map").at("y") == 2);
             }
 
-            AND_THEN("we should not be able to get Lua global registered C functions back as function, for memory safety reasons") {
+            AND_THEN("we should be able to get Lua global registered C functions back as function, since they are plain C closures") {
                 auto f = Moon::Get<std::function<void(bool)>>("f");
-                REQUIRE(logs.ErrorCheck());
                 auto f2 = Moon::Get<std::function<std::string(int, int)>>("Foo");
-                REQUIRE(logs.ErrorCheck());
                 auto f3 = Moon::Get<std::function<std::string(bool)>>("BarFoo");
-                REQUIRE(logs.ErrorCheck());
-                REQUIRE_FALSE(f);
-                REQUIRE_FALSE(f2);
-                REQUIRE_FALSE(f3);
+                REQUIRE(f);
+                REQUIRE(f2);
+                REQUIRE(f3);
+                b = false;
+                f(true);
+                REQUIRE(b);
+                REQUIRE(f2(1, 2) == "3");
+                REQUIRE(f3(true) == "passed");
             }
         }
 
@@ -295,7 +297,7 @@ SCENARIO("push global values to Lua stack", "[basic][global]") {
                 REQUIRE(view["floating"] == 2.f);
                 REQUIRE(("passed" == view["string"]));
                 REQUIRE(view["bool"]);
-                REQUIRE(view["f"].GetType() == moon::LuaType::UserData);
+                REQUIRE(view["f"].GetType() == moon::LuaType::Function);
                 REQUIRE(view["f"].Call<std::string>("passed") == "passed");
             }
 
@@ -313,3 +315,182 @@ SCENARIO("push global values to Lua stack", "[basic][global]") {
     REQUIRE(logs.NoErrors());
     Moon::CloseState();
 }
+
+TEST_CASE("get and push string views", "[basic][global]") {
+    Moon::Init();
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    BEGIN_STACK_GUARD
+
+    SECTION("strings with embedded zeros are kept") {
+        std::string binary{"a\0b", 3};
+        Moon::Set("binary", binary);
+        Moon::Set("view", std::string_view{binary});
+        REQUIRE(Moon::RunCode("assert(#binary == 3 and binary == view)"));
+        REQUIRE(Moon::Get<std::string>("binary") == binary);
+        REQUIRE(Moon::Get<std::string_view>("view") == binary);
+    }
+
+    SECTION("functions receive and return views") {
+        Moon::RegisterFunction("Length", [](std::string_view value) { return value.size(); });
+        Moon::RegisterFunction("Head", [](std::string_view value) { return value.substr(0, 2); });
+        REQUIRE(Moon::RunCode("assert(Length('payload') == 7)"));
+        REQUIRE(Moon::RunCode("assert(Head('payload') == 'pa')"));
+    }
+
+    SECTION("views as keys") {
+        std::string key{"x.y"};
+        Moon::At(std::string_view{key}.substr(0, 1)) = std::map<std::string_view, int>{{"y", 2}};
+        REQUIRE(Moon::RunCode("assert(x.y == 2)"));
+        REQUIRE(Moon::At(std::string_view{"x"})[std::string_view{key}.substr(2)] == 2);
+        auto map = Moon::Get<std::unordered_map<std::string_view, int>>("x");
+        REQUIRE(map.at("y") == 2);
+    }
+
+    END_STACK_GUARD
+    INFO(logs.GetError())
+    REQUIRE(logs.NoErrors());
+    Moon::CloseState();
+}
+
+TEST_CASE("push and get arrays and contiguous buffers", "[basic][global]") {
+    Moon::Init();
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    BEGIN_STACK_GUARD
+    lua_State* L = Moon::GetState();
+
+    SECTION("large numeric vectors") {
+        std::vector<double> values(100000);
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = (double)i + 0.5;
+        }
+        Moon::Set("values", values);
+        REQUIRE(Moon::RunCode("assert(#values == 100000 and values[100000] == 99999.5)"));
+        REQUIRE(Moon::Get<std::vector<double>>("values") == values);
+    }
+
+    SECTION("vectors of booleans and maps") {
+        Moon::Set("flags", std::vector<bool>{true, false, true});
+        REQUIRE(Moon::RunCode("assert(#flags == 3 and flags[1] and not flags[2])"));
+        Moon::Set("map", std::unordered_map<std::string, std::vector<int>>{{"x", {1, 2}}});
+        REQUIRE(Moon::RunCode("assert(map.x[2] == 2)"));
+        REQUIRE(Moon::Get<std::unordered_map<std::string, std::vector<int>>>("map").at("x")[1] == 2);
+    }
+
+    SECTION("std::array") {
+        Moon::Set("array", std::array<int, 3>{1, 2, 3});
+        REQUIRE(Moon::RunCode("assert(#array == 3 and array[3] == 3)"));
+        auto array = Moon::Get<std::array<int, 3>>("array");
+        REQUIRE(array[2] == 3);
+        auto larger = Moon::Get<std::array<int, 5>>("array");
+        REQUIRE(larger[2] == 3);
+        REQUIRE(larger[3] == 0);
+    }
+
+    SECTION("contiguous buffers") {
+        float buffer[4] = {1.5f, 2.5f, 3.5f, 4.5f};
+        moon::Stack::PushArray(L, buffer, 4);
+        lua_setglobal(L, "buffer");
+        REQUIRE(Moon::RunCode("assert(#buffer == 4 and buffer[4] == 4.5)"));
+        float read[8]{};
+        lua_getglobal(L, "buffer");
+        REQUIRE(moon::Stack::GetArray(L, -1, read, 8) == 4);
+        REQUIRE(read[3] == 4.5f);
+        REQUIRE(moon::Stack::GetArray(L, -1, read, 2) == 2);
+        Moon::Pop();
+    }
+
+    END_STACK_GUARD
+    INFO(logs.GetError())
+    REQUIRE(logs.NoErrors());
+    Moon::CloseState();
+}
+
+TEST_CASE("try to get values without logging errors", "[basic][global]") {
+    Moon::Init();
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    BEGIN_STACK_GUARD
+
+    REQUIRE(Moon::RunCode("int = 42; float = 1.5; integral = 2.0; flag = false; str = 'passed'; num = '7'; t = {a = {b = 0}}"));
+
+    SECTION("values that can be read") {
+        auto integer = Moon::TryGet<int>("int");
+        REQUIRE(integer.HasValue());
+        REQUIRE(*integer == 42);
+        REQUIRE(Moon::TryGet<double>("float").GetValue() == 1.5);
+        REQUIRE(Moon::TryGet<double>("int").GetValue() == 42.0);
+        REQUIRE(Moon::TryGet<int>("integral").GetValue() == 2);
+        REQUIRE(Moon::TryGet<int>("num").GetValue() == 7);
+        auto flag = Moon::TryGet<bool>("flag");
+        REQUIRE(flag);
+        REQUIRE_FALSE(*flag);
+        REQUIRE(Moon::TryGet<std::string>("str").GetValue() == "passed");
+        auto zero = Moon::TryGet<int>("t", "a", "b");
+        REQUIRE(zero.GetError() == moon::ValueError::None);
+        REQUIRE(*zero == 0);
+        REQUIRE(Moon::At("t")["a"]["b"].TryGet<int>().HasValue());
+        REQUIRE(Moon::TryGet<std::map<std::string, int>>("t", "a").GetValue().at("b") == 0);
+    }
+
+    SECTION("values that can not be read") {
+        REQUIRE(Moon::TryGet<int>("none").GetError() == moon::ValueError::Missing);
+        REQUIRE(Moon::TryGet<int>("t", "x", "b").GetError() == moon::ValueError::Missing);
+        REQUIRE(Moon::TryGet<int>("t", "a", "b", "c").GetError() == moon::ValueError::TypeMismatch);
+        REQUIRE(Moon::TryGet<int>("float").GetError() == moon::ValueError::TypeMismatch);
+        REQUIRE(Moon::TryGet<int>("str").GetError() == moon::ValueError::TypeMismatch);
+        REQUIRE(Moon::TryGet<bool>("int").GetError() == moon::ValueError::TypeMismatch);
+        REQUIRE(Moon::TryGet<std::string>("t").GetError() == moon::ValueError::TypeMismatch);
+        REQUIRE(Moon::TryGet<std::vector<int>>("int").GetError() == moon::ValueError::TypeMismatch);
+        REQUIRE(Moon::TryGet<int>("none").ValueOr(-1) == -1);
+        Moon::Set("big", (lua_Integer)1 << 40, "negative", -1);
+        REQUIRE(Moon::TryGet<int>("big").GetError() == moon::ValueError::OutOfRange);
+        REQUIRE(Moon::TryGet<long long>("big").HasValue());
+        REQUIRE(Moon::TryGet<unsigned>("negative").GetError() == moon::ValueError::OutOfRange);
+    }
+
+    END_STACK_GUARD
+    INFO(logs.GetError())
+    REQUIRE(logs.NoErrors());
+    Moon::CloseState();
+}
+
+TEST_CASE("access globals and fields with interned keys", "[basic][global]") {
+    Moon::Init();
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    BEGIN_STACK_GUARD
+    REQUIRE(Moon::RunCode("frame = 10; config = {window = {width = 800}}; function Tick(x) return x + 1 end"));
+    {
+        auto frame = Moon::MakeKey("frame");
+        auto window = Moon::MakeKey("window");
+        auto width = Moon::MakeKey("width");
+        auto tick = Moon::MakeKey("Tick");
+        REQUIRE(frame.IsLoaded());
+        REQUIRE(frame.GetName() == "frame");
+        REQUIRE(Moon::Get<int>(frame) == 10);
+        REQUIRE(Moon::GetNested<int>("config", window, width) == 800);
+        REQUIRE(Moon::GetType("config", window) == moon::LuaType::Table);
+        REQUIRE(Moon::Check<int>(frame));
+        REQUIRE(Moon::TryGet<int>("config", window, width).GetValue() == 800);
+        REQUIRE(Moon::Call<int>(tick, 1) == 2);
+
+        Moon::Set(frame, 11);
+        REQUIRE(Moon::Get<int>("frame") == 11);
+        Moon::SetNested("config", window, "height", 600);
+        REQUIRE(Moon::GetNested<int>("config", "window", "height") == 600);
+        REQUIRE(Moon::At(frame).Get<int>() == 11);
+        REQUIRE(Moon::At("config")[window][width] == 800);
+
+        Moon::Clean(frame);
+        REQUIRE(Moon::GetType(frame) == moon::LuaType::Null);
+        auto moved = std::move(frame);
+        REQUIRE_FALSE(frame.IsLoaded());
+        REQUIRE(moved.IsLoaded());
+    }
+    END_STACK_GUARD
+    INFO(logs.GetError())
+    REQUIRE(logs.NoErrors());
+    Moon::CloseState();
+}
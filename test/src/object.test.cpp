@@ -1,6 +1,7 @@
 #include <catch2/catch.hpp>
 
 #include "helpers.h"
+#include "userdefinedtype.h"
 
 SCENARIO("moon object reference base class", "[basic][reference]") {
     Moon::Init();
@@ -213,6 +214,52 @@ TEST_CASE("dynamic object type", "[object][basic]") {
             REQUIRE(o2.GetKey() == topRefIndex + 1);
         }
 
+        {  // shared
+            Moon::Push(20);
+            auto o = Moon::MakeObjectFromIndex();
+            Moon::Pop();
+            REQUIRE_FALSE(o.IsShared());
+            REQUIRE(o.GetUseCount() == 1);
+            o.Share();
+            auto o2 = o;
+            moon::Object o3;
+            o3 = o2;
+            REQUIRE(o.IsShared());
+            REQUIRE(o3.GetUseCount() == 3);
+            REQUIRE(o == o2);
+            REQUIRE(o2 == o3);
+            REQUIRE(o3.GetKey() == topRefIndex + 1);
+            o2.Unload();
+            REQUIRE(o.GetUseCount() == 2);
+            REQUIRE(o3.As<int>() == 20);
+
+            o3 = 30;  // Detaches from shared slot
+            REQUIRE(o3.IsShared());
+            REQUIRE(o3 != o);
+            REQUIRE(o.As<int>() == 20);
+            REQUIRE(o3.As<int>() == 30);
+            REQUIRE(o.GetUseCount() == 1);
+        }
+
+        {  // assignment reuses slot
+            auto o = Moon::MakeObject(20);
+            int key = o.GetKey();
+            o = "passed";
+            REQUIRE(o.GetKey() == key);
+            REQUIRE(o.As<std::string>() == "passed");
+        }
+
+        {  // assigning nil releases slot, so it is never handed out twice
+            auto o = Moon::MakeObject(20);
+            o = moon::Borrow<UserDefinedType>(nullptr);
+            REQUIRE(o.GetKey() == LUA_REFNIL);
+            auto o2 = Moon::MakeObject(30);
+            auto o3 = Moon::MakeObject(40);
+            REQUIRE(o2.GetKey() != o3.GetKey());
+            REQUIRE(o2.As<int>() == 30);
+            REQUIRE(o3.As<int>() == 40);
+        }
+
         END_STACK_GUARD
     }
 
@@ -459,7 +506,7 @@ SCENARIO("lua dynamic objects", "[object][basic]") {
                 REQUIRE(o.Is<std::vector<int>>());
                 REQUIRE(o[1] == 1);
 
-                REQUIRE(o2.GetType() == moon::LuaType::UserData);
+                REQUIRE(o2.GetType() == moon::LuaType::Function);
                 REQUIRE(o2.Call<bool>(true));
             }
         }
@@ -619,3 +666,70 @@ SCENARIO("callable objects", "[object][functions][basic]") {
     REQUIRE(logs.NoErrors());
     Moon::CloseState();
 }
+
+struct Entity {
+    int id{0};
+    double speed{1.0};
+    std::string name;
+    std::vector<int> tags;
+};
+
+template <>
+struct moon::Fields<Entity> {
+    static constexpr auto value = std::make_tuple(moon::MakeField("id", &Entity::id), moon::MakeField("speed", &Entity::speed),
+                                                  moon::MakeField("name", &Entity::name), moon::MakeField("tags", &Entity::tags));
+};
+
+TEST_CASE("get sibling fields and described structs", "[object][basic]") {
+    Moon::Init();
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    BEGIN_STACK_GUARD
+
+    REQUIRE(Moon::RunCode("config = {entity = {id = 7, speed = 2.5, name = 'player', tags = {1, 2}}, partial = {id = 3}}"));
+
+    SECTION("sibling fields") {
+        auto entity = Moon::At("config")["entity"].Get<moon::Object>();
+        auto [id, speed, name] = entity.GetFields<int, double, std::string>("id", "speed", "name");
+        REQUIRE(id == 7);
+        REQUIRE(speed == 2.5);
+        REQUIRE(name == "player");
+        REQUIRE(entity.GetFields<std::vector<int>>("tags") == std::vector<int>{1, 2});
+
+        auto [proxyId, proxyName] = Moon::At("config")["entity"].GetFields<int, std::string>("id", "name");
+        REQUIRE(proxyId == 7);
+        REQUIRE(proxyName == "player");
+
+        auto path = Moon::MakePath("config", "entity");
+        REQUIRE(std::get<1>(path.GetFields<int, double>("id", "speed")) == 2.5);
+    }
+
+    SECTION("described structs") {
+        auto entity = Moon::GetNested<Entity>("config", "entity");
+        REQUIRE(entity.id == 7);
+        REQUIRE(entity.speed == 2.5);
+        REQUIRE(entity.name == "player");
+        REQUIRE(entity.tags == std::vector<int>{1, 2});
+
+        auto partial = Moon::At("config")["partial"].Get<Entity>();
+        REQUIRE(partial.id == 3);
+        REQUIRE(partial.speed == 1.0);
+        REQUIRE(partial.name.empty());
+
+        Moon::Set("copy", Entity{9, 0.5, "enemy", {3}});
+        REQUIRE(Moon::RunCode("assert(copy.id == 9 and copy.speed == 0.5 and copy.name == 'enemy' and copy.tags[1] == 3)"));
+        REQUIRE(Moon::Check<Entity>("copy"));
+    }
+
+    SECTION("fields of values that are not tables") {
+        auto number = Moon::MakeObject(1);
+        REQUIRE(number.GetFields<int, int>("a", "b") == std::tuple<int, int>{0, 0});
+        REQUIRE_FALSE(logs.NoErrors());
+        logs.Clear();
+    }
+
+    END_STACK_GUARD
+    INFO(logs.GetError())
+    REQUIRE(logs.NoErrors());
+    Moon::CloseState();
+}
@@ -0,0 +1,50 @@
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+TEST_CASE("parallel map over pooled states", "[parallel][pool]") {
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    moon::StatePool pool{4};
+
+    SECTION("results keep input order") {
+        std::vector<int> input(10000);
+        for (size_t i = 0; i < input.size(); ++i) {
+            input[i] = (int)i;
+        }
+        auto squares = moon::ParallelMap<int64_t>(pool, "function(x) return x * x end", input);
+        REQUIRE(squares.size() == input.size());
+        for (size_t i = 0; i < input.size(); ++i) {
+            REQUIRE(squares[i] == (int64_t)i * (int64_t)i);
+        }
+        REQUIRE(pool.GetAvailable() == 4);
+        auto odd = moon::ParallelMap<bool>(pool, "function(x) return x % 2 == 1 end", input, 64);
+        REQUIRE(odd.size() == input.size());
+        REQUIRE_FALSE(odd[0]);
+        REQUIRE(odd[9999]);
+    }
+
+    SECTION("strings and maps without a pool") {
+        std::vector<std::string> input{"a", "bb", "ccc"};
+        REQUIRE(moon::ParallelMap<std::string>(pool, "string.upper", input) == std::vector<std::string>{"A", "BB", "CCC"});
+        REQUIRE(moon::ParallelMap<size_t>("function(s) return #s end", input) == std::vector<size_t>{1, 2, 3});
+        REQUIRE(moon::ParallelMap<int>(pool, "function(x) return x end", std::vector<int>{}).empty());
+    }
+
+    SECTION("errors") {
+        std::vector<int> input{1, 2, 3, 4};
+        REQUIRE(moon::ParallelMap<int>(pool, "function(x) if x == 3 then error('bad row') end return x end", input).empty());
+        REQUIRE(error.find("bad row") != std::string::npos);
+        logs.Clear();
+        REQUIRE(moon::ParallelMap<int>(pool, "function(x) return 'text' end", input).empty());
+        REQUIRE(error.find("unexpected type") != std::string::npos);
+        logs.Clear();
+        REQUIRE(moon::ParallelMap<int>(pool, "function(x", input).empty());
+        REQUIRE_FALSE(logs.NoErrors());
+        logs.Clear();
+        REQUIRE(pool.GetAvailable() == 4);
+    }
+
+    INFO(logs.GetError())
+    REQUIRE(logs.NoErrors());
+}
@@ -0,0 +1,70 @@
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+SCENARIO("precompiled key paths", "[path][basic]") {
+    Moon::Init();
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    BEGIN_STACK_GUARD
+
+    GIVEN("nested globals") {
+        REQUIRE(Moon::RunCode("config = {window = {width = 800, sizes = {10, 20}}}"));
+
+        WHEN("paths are created") {
+            auto width = Moon::MakePath("config", "window", "width");
+            auto size = Moon::MakePath("config", "window", "sizes", 2);
+            auto missing = Moon::MakePath("config", "missing", "width");
+
+            THEN("values can be read and checked") {
+                REQUIRE(width.GetSize() == 3);
+                REQUIRE(width.Get<int>() == 800);
+                REQUIRE(width.Check<int>());
+                REQUIRE(width.GetType() == moon::LuaType::Number);
+                REQUIRE(size.Get<int>() == 20);
+                REQUIRE(missing.GetType() == moon::LuaType::Null);
+                REQUIRE_FALSE(missing.Check<int>());
+            }
+
+            AND_THEN("values can be set, creating missing tables") {
+                REQUIRE(width.Set(1024));
+                REQUIRE(Moon::RunCode("assert(config.window.width == 1024)"));
+                REQUIRE(missing.Set(2));
+                REQUIRE(Moon::RunCode("assert(config.missing.width == 2)"));
+                width.Clean();
+                REQUIRE(Moon::RunCode("assert(config.window.width == nil)"));
+            }
+
+            AND_THEN("invalid paths report errors") {
+                auto invalid = Moon::MakePath("config", "window", "width", "x");
+                REQUIRE(invalid.Get<int>() == 0);
+                REQUIRE(logs.ErrorCheck());
+                REQUIRE_FALSE(invalid.Set(1));
+                REQUIRE(logs.ErrorCheck());
+            }
+        }
+
+        AND_WHEN("parent table is cached") {
+            auto width = Moon::MakePath("config", "window", "width");
+            width.CacheParent();
+            REQUIRE_FALSE(width.IsCached());
+            REQUIRE(width.Get<int>() == 800);
+            REQUIRE(width.IsCached());
+
+            THEN("cached parent is used until invalidated") {
+                REQUIRE(Moon::RunCode("config.window = {width = 640}"));
+                REQUIRE(width.Get<int>() == 800);
+                width.Invalidate();
+                REQUIRE(width.Get<int>() == 640);
+                moon::Path moved{std::move(width)};
+                REQUIRE(moved.IsCached());
+                REQUIRE(moved.Get<int>() == 640);
+            }
+        }
+    }
+
+    END_STACK_GUARD
+    INFO(logs.GetError())
+    REQUIRE(logs.NoErrors());
+    Moon::CloseState();
+}
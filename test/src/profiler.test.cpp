@@ -0,0 +1,97 @@
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+namespace {
+std::optional<moon::CallRecord> findRecord(moon::ProfileCategory category, const std::string& name) {
+    for (auto& record : moon::Profiler::GetRecords()) {
+        if (record.category == category && record.name == name) {
+            return record;
+        }
+    }
+    return std::nullopt;
+}
+}  // namespace
+
+TEST_CASE("instrument calls across boundary", "[profiler]") {
+    Moon::Init();
+    moon::Profiler::Reset();
+    BEGIN_STACK_GUARD
+
+    Moon::RegisterFunction("Counted", [](int a) { return a * 2; });
+    REQUIRE(Moon::RunCode("function Target(a) local r = 0 for i = 1, 10 do r = r + Counted(a) end return r end"));
+    REQUIRE(Moon::Call<int>("Target", 1) == 20);
+    REQUIRE(Moon::Call<int>("Target", 2) == 40);
+
+    if constexpr (moon::Profiler::s_enabled) {
+        auto function = findRecord(moon::ProfileCategory::Function, "Counted");
+        REQUIRE(function.has_value());
+        REQUIRE(function->calls == 20);
+        auto call = findRecord(moon::ProfileCategory::Call, "Target");
+        REQUIRE(call.has_value());
+        REQUIRE(call->calls == 2);
+        REQUIRE(call->nanoseconds >= function->nanoseconds);
+        moon::Profiler::Reset();
+        REQUIRE(findRecord(moon::ProfileCategory::Call, "Target")->calls == 0);
+    } else {
+        REQUIRE_FALSE(findRecord(moon::ProfileCategory::Function, "Counted").has_value());
+        REQUIRE_FALSE(findRecord(moon::ProfileCategory::Call, "Target").has_value());
+    }
+
+    END_STACK_GUARD
+    Moon::CloseState();
+}
+
+TEST_CASE("sample Lua hotspots", "[profiler]") {
+    Moon::Init();
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    moon::SamplingProfiler profiler{Moon::GetState()};
+    BEGIN_STACK_GUARD
+
+    SECTION("folded stacks and hotspots") {
+        REQUIRE(Moon::RunCode("function Hot() local r = 0 for i = 1, 1000 do r = r + i end return r end"));
+        REQUIRE(profiler.Start(100));
+        REQUIRE(profiler.IsRunning());
+        REQUIRE(Moon::RunCode("for i = 1, 100 do Hot() end"));
+        profiler.Stop();
+        REQUIRE_FALSE(profiler.IsRunning());
+        size_t samples = profiler.GetSampleCount();
+        REQUIRE(samples > 0);
+        REQUIRE(Moon::RunCode("for i = 1, 100 do Hot() end"));
+        REQUIRE(profiler.GetSampleCount() == samples);
+
+        auto hotspots = profiler.GetHotspots();
+        REQUIRE_FALSE(hotspots.empty());
+        REQUIRE(hotspots.front().second >= hotspots.back().second);
+        size_t total = 0;
+        for (const auto& [line, count] : hotspots) {
+            total += count;
+        }
+        REQUIRE(total == samples);
+
+        std::string dump = profiler.Dump();
+        REQUIRE(dump.find("Hot (") != std::string::npos);
+        std::istringstream lines{dump};
+        std::string line;
+        while (std::getline(lines, line)) {
+            REQUIRE(line.find(' ') != std::string::npos);
+            REQUIRE(std::stoul(line.substr(line.rfind(' ') + 1)) > 0);
+        }
+        profiler.Reset();
+        REQUIRE(profiler.GetSampleCount() == 0);
+        REQUIRE(profiler.Dump().empty());
+    }
+
+    SECTION("refuse to replace another hook") {
+        REQUIRE(Moon::RunCode("debug.sethook(function() end, '', 1000)"));
+        REQUIRE_FALSE(profiler.Start());
+        REQUIRE_FALSE(error.empty());
+        REQUIRE(Moon::RunCode("debug.sethook()"));
+        REQUIRE(profiler.Start());
+    }
+
+    END_STACK_GUARD
+    profiler.Stop();
+    Moon::CloseState();
+}
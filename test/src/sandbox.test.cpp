@@ -0,0 +1,70 @@
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+TEST_CASE("sandboxed execution", "[sandbox][state]") {
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    moon::State state{std::make_unique<moon::Allocator>(), moon::Sandbox::Safe};
+
+    SECTION("only safe libraries are opened") {
+        REQUIRE(state.RunCode("hasIO = io ~= nil; hasOS = os ~= nil; hasLoadfile = loadfile ~= nil; hasString = string.format ~= nil"));
+        REQUIRE_FALSE(state.Get<bool>("hasIO"));
+        REQUIRE_FALSE(state.Get<bool>("hasOS"));
+        REQUIRE_FALSE(state.Get<bool>("hasLoadfile"));
+        REQUIRE(state.Get<bool>("hasString"));
+        REQUIRE(state.RunCode("binary = load(string.dump(function() end)) == nil; text = load('return ...', 'text', 'b', {})(1)"));
+        REQUIRE(state.Get<bool>("binary"));
+        REQUIRE(state.Get<int>("text") == 1);
+    }
+
+    SECTION("code within limits runs") {
+        moon::SandboxLimits limits{1000000, std::chrono::milliseconds{1000}, 1 << 24};
+        REQUIRE(state.RunSandboxed("total = 0; for i = 1, 100 do total = total + i end", limits) == moon::SandboxStatus::Ok);
+        REQUIRE(state.Get<int>("total") == 5050);
+        REQUIRE(logs.NoErrors());
+    }
+
+    SECTION("instruction budget") {
+        moon::Sandbox sandbox{state.GetState(), {10000}};
+        REQUIRE(sandbox.RunCode("while true do end") == moon::SandboxStatus::InstructionLimit);
+        REQUIRE(sandbox.GetInstructions() >= 10000);
+        REQUIRE(logs.ErrorCheck());
+        REQUIRE(sandbox.RunCode("while true do pcall(function() while true do end end) end") == moon::SandboxStatus::InstructionLimit);
+        REQUIRE(logs.ErrorCheck());
+        REQUIRE(state.RunCode("x = 0; for i = 1, 100000 do x = x + 1 end"));
+        REQUIRE(state.Get<int>("x") == 100000);
+    }
+
+    SECTION("wallclock deadline") {
+        moon::SandboxLimits limits{0, std::chrono::milliseconds{20}};
+        REQUIRE(state.RunSandboxed("while true do end", limits) == moon::SandboxStatus::Timeout);
+        REQUIRE(logs.ErrorCheck());
+    }
+
+    SECTION("memory cap") {
+        moon::SandboxLimits limits{0, std::chrono::milliseconds{0}, state.GetAllocator()->GetUsage() + 64 * 1024};
+        REQUIRE(state.RunSandboxed("t = {}; for i = 1, 1000000 do t[i] = tostring(i) end", limits) == moon::SandboxStatus::MemoryLimit);
+        REQUIRE(logs.ErrorCheck());
+        REQUIRE(state.GetAllocator()->GetLimit() == 0);
+        REQUIRE(state.RunCode("t = nil; collectgarbage()"));
+    }
+
+    SECTION("errors") {
+        moon::SandboxLimits limits{1000};
+        REQUIRE(state.RunSandboxed("this is not lua", limits) == moon::SandboxStatus::Error);
+        REQUIRE(logs.ErrorCheck());
+        REQUIRE(state.RunSandboxed("\x1bLua", limits) == moon::SandboxStatus::Error);
+        REQUIRE(logs.GetError().find("binary") != std::string::npos);
+        logs.Clear();
+        REQUIRE(state.RunSandboxed("error('failed')", limits) == moon::SandboxStatus::Error);
+        REQUIRE(logs.GetError().find("failed") != std::string::npos);
+        logs.Clear();
+        lua_sethook(state.GetState(), [](lua_State*, lua_Debug*) {}, LUA_MASKCOUNT, 100);
+        REQUIRE(state.RunSandboxed("x = 1", limits) == moon::SandboxStatus::Error);
+        REQUIRE(logs.ErrorCheck());
+        lua_sethook(state.GetState(), nullptr, 0, 0);
+    }
+
+    REQUIRE(state.GetTop() == 0);
+}
@@ -0,0 +1,86 @@
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+namespace {
+void writeScript(const char* path, const char* code) {
+    std::ofstream file{path, std::ios::trunc};
+    file << code;
+}
+}  // namespace
+
+TEST_CASE("hot reload of script files", "[scriptregistry][chunk]") {
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    moon::State state;
+    const char* configPath = "scripts/reload_config.lua";
+    const char* rulesPath = "scripts/reload_rules.lua";
+    const char* otherPath = "scripts/reload_other.lua";
+    writeScript(configPath, "limit = 10");
+    writeScript(rulesPath, "function Allowed(x) return x <= config.limit end");
+    writeScript(otherPath, "return {name = 'other'}");
+
+    auto registry = state.MakeScriptRegistry();
+    REQUIRE(registry.Add("config", configPath));
+    REQUIRE(registry.Add("rules", rulesPath, {"config"}));
+    REQUIRE(registry.Add("other", otherPath));
+    REQUIRE(registry.GetSize() == 3);
+    REQUIRE(registry.Contains("rules"));
+    REQUIRE(logs.NoErrors());
+
+    SECTION("modules are isolated from globals") {
+        REQUIRE(state.MakePath("config", "limit").Get<int>() == 10);
+        REQUIRE(state.MakePath("other", "name").Get<std::string>() == "other");
+        REQUIRE(state.RunCode("isolated = limit == nil and Allowed == nil and rules.Allowed(5) and not rules.Allowed(11)"));
+        REQUIRE(state.Get<bool>("isolated"));
+    }
+
+    SECTION("unchanged scripts are not reloaded") {
+        REQUIRE(state.RunCode("config.limit = 20"));
+        REQUIRE(registry.Reload() == 0);
+        REQUIRE(state.MakePath("config", "limit").Get<int>() == 20);
+    }
+
+    SECTION("changed scripts and dependents are reloaded in place") {
+        REQUIRE(state.RunCode("oldConfig = config; oldAllowed = rules.Allowed; oldOther = other"));
+        writeScript(configPath, "limit = 100 -- raised");
+        REQUIRE(registry.Reload() == 2);
+        REQUIRE(state.MakePath("config", "limit").Get<int>() == 100);
+        REQUIRE(state.RunCode("kept = oldConfig == config and package.loaded.config == config and oldOther == other"));
+        REQUIRE(state.Get<bool>("kept"));
+        REQUIRE(state.RunCode("raised = rules.Allowed(50) and oldAllowed(50)"));
+        REQUIRE(state.Get<bool>("raised"));
+        REQUIRE(registry.Reload() == 0);
+        REQUIRE(logs.NoErrors());
+    }
+
+    SECTION("edits keeping file size are reloaded") {
+        std::this_thread::sleep_for(std::chrono::milliseconds{50});  // Past timestamp granularity of file system
+        writeScript(configPath, "limit = 99");
+        REQUIRE(registry.Reload() == 2);
+        REQUIRE(state.MakePath("config", "limit").Get<int>() == 99);
+    }
+
+    SECTION("broken scripts keep previous module") {
+        writeScript(configPath, "limit = = 1");
+        REQUIRE(registry.Reload() == 0);
+        REQUIRE(logs.ErrorCheck());
+        REQUIRE(state.MakePath("config", "limit").Get<int>() == 10);
+        REQUIRE(state.RunCode("stillAllowed = rules.Allowed(5)"));
+        REQUIRE(state.Get<bool>("stillAllowed"));
+    }
+
+    SECTION("registration errors") {
+        REQUIRE_FALSE(registry.Add("config", configPath));
+        REQUIRE(logs.ErrorCheck());
+        REQUIRE_FALSE(registry.Add("missing", otherPath, {"unknown"}));
+        REQUIRE(logs.ErrorCheck());
+        REQUIRE_FALSE(registry.GetModule("unknown").IsLoaded());
+        REQUIRE(logs.ErrorCheck());
+    }
+
+    std::remove(configPath);
+    std::remove(rulesPath);
+    std::remove(otherPath);
+    REQUIRE(state.GetTop() == 0);
+}
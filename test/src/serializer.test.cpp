@@ -0,0 +1,97 @@
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+TEST_CASE("binary serialization of Lua values", "[serializer]") {
+    Moon::Init();
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    BEGIN_STACK_GUARD
+    lua_State* L = Moon::GetState();
+
+    SECTION("scalars keep their types") {
+        REQUIRE(Moon::RunCode("values = {0, 127, -1, -32, -33, 200, -40000, 2^31, math.maxinteger, math.mininteger, 1.0, 0.5, -2.5e300,"
+                              " true, false, '', 'short', string.rep('x', 100), string.rep('y', 70000), 'a\\0b'}"));
+        lua_getglobal(L, "values");
+        auto values = Moon::Get<moon::Object>(-1);
+        Moon::Pop();
+        REQUIRE(Moon::RunCode("copies = {}"));
+        for (int i = 1; i <= 20; ++i) {
+            std::vector<uint8_t> buffer;
+            lua_getglobal(L, "values");
+            lua_rawgeti(L, -1, i);
+            REQUIRE(Moon::Encode(-1, buffer));
+            Moon::Pop(2);
+            REQUIRE(moon::Serializer::Decode(L, buffer.data(), buffer.size()) == buffer.size());
+            lua_getglobal(L, "copies");
+            lua_insert(L, -2);
+            lua_rawseti(L, -2, i);
+            Moon::Pop();
+        }
+        REQUIRE(Moon::RunCode("for i = 1, 20 do assert(math.type(values[i]) == math.type(copies[i]) and values[i] == copies[i], i) end"));
+        REQUIRE(values.IsLoaded());
+    }
+
+    SECTION("small values are compact") {
+        std::vector<uint8_t> buffer;
+        Moon::Push(5);
+        REQUIRE(Moon::Encode(-1, buffer));
+        Moon::Push("abc");
+        REQUIRE(Moon::Encode(-1, buffer));
+        Moon::Pop(2);
+        REQUIRE(buffer.size() == 5);
+        size_t read = moon::Serializer::Decode(L, buffer.data(), buffer.size());
+        REQUIRE(read == 1);
+        REQUIRE(moon::Serializer::Decode(L, buffer.data() + read, buffer.size() - read) == 4);
+        REQUIRE(Moon::Get<std::string>(-1) == "abc");
+        REQUIRE(Moon::Get<int>(-2) == 5);
+        Moon::Pop(2);
+    }
+
+    SECTION("nested tables, shared tables and cycles") {
+        REQUIRE(Moon::RunCode("shared = {1, 2}; t = {1, 'two', 3.5, nested = {deep = {x = 1}}, a = shared, b = shared, [10] = 'sparse'}; "
+                              "t.self = t"));
+        std::vector<uint8_t> buffer;
+        REQUIRE(moon::Serializer::Encode(Moon::At("t").Get<moon::Object>(), buffer));
+        auto copy = Moon::Decode(buffer);
+        REQUIRE(copy.IsLoaded());
+        Moon::Set("copy", copy);
+        REQUIRE(Moon::RunCode("assert(copy ~= t and copy[1] == 1 and copy[2] == 'two' and copy[3] == 3.5 and copy[4] == nil)"));
+        REQUIRE(Moon::RunCode("assert(copy.nested.deep.x == 1 and copy[10] == 'sparse')"));
+        REQUIRE(Moon::RunCode("assert(copy.a == copy.b and copy.a ~= shared and copy.a[2] == 2)"));
+        REQUIRE(Moon::RunCode("assert(copy.self == copy)"));
+    }
+
+    SECTION("unsupported values") {
+        std::vector<uint8_t> buffer{1, 2, 3};
+        REQUIRE(Moon::RunCode("bad = {ok = 1, f = print}"));
+        lua_getglobal(L, "bad");
+        REQUIRE_FALSE(Moon::Encode(-1, buffer));
+        Moon::Pop();
+        REQUIRE(buffer == std::vector<uint8_t>{1, 2, 3});
+        REQUIRE_FALSE(logs.NoErrors());
+        logs.Clear();
+    }
+
+    SECTION("malformed data") {
+        REQUIRE(Moon::RunCode("t = {1, 2, 3, x = 'string'}"));
+        std::vector<uint8_t> buffer;
+        REQUIRE(moon::Serializer::Encode(Moon::At("t").Get<moon::Object>(), buffer));
+        for (size_t size = 0; size < buffer.size(); ++size) {
+            REQUIRE(moon::Serializer::Decode(L, buffer.data(), size) == 0);
+        }
+        std::vector<uint8_t> reference{0xc1, 1, 0, 0, 0};
+        REQUIRE_FALSE(Moon::Decode(reference).IsLoaded());
+        std::vector<uint8_t> huge{0xde, 0xff, 0xff, 0xff, 0xff, 0, 0, 0, 0};
+        REQUIRE_FALSE(Moon::Decode(huge).IsLoaded());
+        std::vector<uint8_t> nilKey{0xde, 0, 0, 0, 0, 1, 0, 0, 0, 0xc0, 0x01};
+        REQUIRE_FALSE(Moon::Decode(nilKey).IsLoaded());
+        REQUIRE_FALSE(logs.NoErrors());
+        logs.Clear();
+    }
+
+    END_STACK_GUARD
+    INFO(logs.GetError())
+    REQUIRE(logs.NoErrors());
+    Moon::CloseState();
+}
@@ -0,0 +1,84 @@
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+#include "userdefinedtype.h"
+
+#ifdef RegisterClass
+#undef RegisterClass
+#endif
+
+SCENARIO("multiple independent Lua states", "[state][basic]") {
+    GIVEN("two moon states") {
+        moon::State first;
+        moon::State second;
+        REQUIRE(first.GetState() != nullptr);
+        REQUIRE(second.GetState() != nullptr);
+        REQUIRE(first.GetState() != second.GetState());
+
+        WHEN("globals are set in each state") {
+            first.Set("value", 1);
+            second.Set("value", "passed");
+
+            THEN("values should not be shared") {
+                REQUIRE(first.Get<int>("value") == 1);
+                REQUIRE(second.Get<std::string>("value") == "passed");
+                REQUIRE(first.RunCode("assert(value == 1)"));
+                REQUIRE(second.RunCode("assert(value == 'passed')"));
+            }
+        }
+
+        WHEN("functions and classes are registered in one state") {
+            first.RegisterFunction("Add", [](int a, int b) { return a + b; });
+            first.RegisterClass<UserDefinedType>();
+
+            THEN("they should only be available in that state") {
+                REQUIRE(first.Call<int>("Add", 1, 2) == 3);
+                REQUIRE(first.RunCode("local s = UserDefinedType(20); assert(s.m_prop == 20)"));
+                REQUIRE(second.GetType("Add") == moon::LuaType::Null);
+                REQUIRE(second.GetType("UserDefinedType") == moon::LuaType::Null);
+            }
+        }
+
+        WHEN("views are used") {
+            first.View()["map"]["x"] = 2;
+            second.At("map") = moon::LuaMap<int>{{"x", 3}};
+
+            THEN("each view should access its own global scope") {
+                REQUIRE(first.At("map")["x"].Get<int>() == 2);
+                REQUIRE(second.View()["map"]["x"].Get<int>() == 3);
+                REQUIRE(first.GetTop() == 0);
+                REQUIRE(second.GetTop() == 0);
+            }
+        }
+    }
+}
+
+TEST_CASE("move and close moon state", "[state][basic]") {
+    moon::State state;
+    state.Set("value", 2);
+    lua_State* L = state.GetState();
+
+    moon::State moved{std::move(state)};
+    REQUIRE(state.GetState() == nullptr);
+    REQUIRE(moved.GetState() == L);
+    REQUIRE(moved.Get<int>("value") == 2);
+
+    moon::State assigned;
+    assigned = std::move(moved);
+    REQUIRE(moved.GetState() == nullptr);
+    REQUIRE(assigned.GetState() == L);
+    REQUIRE(assigned.View().GetState() == L);
+
+    assigned.Close();
+    REQUIRE(assigned.GetState() == nullptr);
+    assigned.Close();
+}
+
+TEST_CASE("moon facade wraps default state", "[state][basic]") {
+    Moon::Init();
+    REQUIRE(Moon::GetDefault().GetState() == Moon::GetState());
+    Moon::GetDefault().Set("value", 3);
+    REQUIRE(Moon::Get<int>("value") == 3);
+    Moon::CloseState();
+    REQUIRE(Moon::GetState() == nullptr);
+}
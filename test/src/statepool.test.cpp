@@ -0,0 +1,85 @@
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+#include "userdefinedtype.h"
+
+#ifdef RegisterClass
+#undef RegisterClass
+#endif
+
+SCENARIO("pool of prewarmed Lua states", "[state][pool]") {
+    GIVEN("a pool with bootstrap callback and scripts") {
+        moon::StatePool pool{
+            2, [](moon::State& state) { state.RegisterClass<UserDefinedType>(); }, {"Base = 10", "function Double(x) return x * 2 end"}};
+        REQUIRE(pool.GetSize() == 2);
+        REQUIRE(pool.GetAvailable() == 2);
+
+        WHEN("a state is acquired") {
+            auto lease = pool.Acquire();
+
+            THEN("state should be bootstrapped") {
+                REQUIRE(lease.IsValid());
+                REQUIRE(pool.GetAvailable() == 1);
+                REQUIRE(lease->Get<int>("Base") == 10);
+                REQUIRE(lease->Call<int>("Double", 2) == 4);
+                REQUIRE(lease->RunCode("local s = UserDefinedType(20); assert(s.m_prop == 20)"));
+            }
+        }
+
+        WHEN("a state is modified and released") {
+            lua_State* L = nullptr;
+            {
+                auto lease = pool.Acquire();
+                L = lease->GetState();
+                REQUIRE(lease->RunCode("Base = 20; NewGlobal = true"));
+                lease->Push(1, 2, 3);
+            }
+            REQUIRE(pool.GetAvailable() == 2);
+
+            THEN("same thread should get the same state back reset to baseline") {
+                auto lease = pool.Acquire();
+                REQUIRE(lease->GetState() == L);
+                REQUIRE(lease->GetTop() == 0);
+                REQUIRE(lease->Get<int>("Base") == 10);
+                REQUIRE(lease->GetType("NewGlobal") == moon::LuaType::Null);
+                REQUIRE(lease->Call<int>("Double", 3) == 6);
+            }
+        }
+
+        WHEN("all states are leased") {
+            auto first = pool.Acquire();
+            auto second = pool.TryAcquire();
+            auto third = pool.TryAcquire();
+
+            THEN("non blocking acquire should fail") {
+                REQUIRE(first);
+                REQUIRE(second);
+                REQUIRE_FALSE(third);
+                REQUIRE(first->GetState() != second->GetState());
+                second.Release();
+                REQUIRE(pool.TryAcquire().IsValid());
+            }
+        }
+
+        WHEN("states are used from multiple threads") {
+            std::vector<std::thread> threads;
+            std::vector<int> results(4, 0);
+            for (size_t i = 0; i < results.size(); ++i) {
+                threads.emplace_back([&pool, &results, i]() {
+                    auto lease = pool.Acquire();
+                    results[i] = lease->Call<int>("Double", (int)i);
+                });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+
+            THEN("every thread should get a valid state") {
+                for (size_t i = 0; i < results.size(); ++i) {
+                    REQUIRE(results[i] == (int)i * 2);
+                }
+                REQUIRE(pool.GetAvailable() == 2);
+            }
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+TEST_CASE("lazy views of Lua tables", "[view][table]") {
+    Moon::Init();
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    BEGIN_STACK_GUARD
+    REQUIRE(Moon::RunCode(R"(
+        rows = {10, 20, 30, 40}
+        matrix = {{1, 2}, {3, 4, 5}}
+        config = {name = 'moon', width = 800, height = 600, [1] = 'skipped', limits = {max = {1, 2, 3}}}
+    )"));
+
+    SECTION("arrays") {
+        auto rows = Moon::Get<moon::ArrayView<int>>("rows");
+        REQUIRE(rows.IsLoaded());
+        REQUIRE(rows.GetSize() == 4);
+        REQUIRE(rows[0] == 10);
+        REQUIRE(rows[3] == 40);
+        REQUIRE(rows.At(4).GetError() == moon::ValueError::Missing);
+        int sum = 0;
+        for (int row : rows) {
+            sum += row;
+        }
+        REQUIRE(sum == 100);
+        REQUIRE(std::vector<int>(rows.begin(), rows.end()) == std::vector<int>{10, 20, 30, 40});
+
+        auto matrix = Moon::Get<moon::ArrayView<moon::ArrayView<int>>>("matrix");
+        REQUIRE(matrix.GetSize() == 2);
+        REQUIRE(matrix[1].GetSize() == 3);
+        REQUIRE(matrix[1][2] == 5);
+
+        REQUIRE(Moon::RunCode("rows[5] = 50"));
+        REQUIRE(rows.GetSize() == 5);
+    }
+
+    SECTION("tables") {
+        auto config = Moon::Get<moon::TableView<moon::Object>>("config");
+        REQUIRE(config["name"].As<std::string>() == "moon");
+        REQUIRE(config.Contains("width"));
+        REQUIRE_FALSE(config.Contains("depth"));
+        REQUIRE(config.At(std::string{"depth"}).HasValue());  // Objects of nil are still objects
+        std::vector<std::string> keys;
+        for (const auto& [key, value] : config) {
+            keys.push_back(key);
+        }
+        std::sort(keys.begin(), keys.end());
+        REQUIRE(keys == std::vector<std::string>{"height", "limits", "name", "width"});
+
+        auto sizes = Moon::GetNested<moon::TableView<int>>("config");
+        REQUIRE(sizes["width"] == 800);
+        REQUIRE(sizes.At("name").GetError() == moon::ValueError::TypeMismatch);
+
+        auto limits = Moon::GetNested<moon::TableView<moon::ArrayView<int>>>("config", "limits");
+        REQUIRE(limits["max"][2] == 3);
+        moon::TableView<int> fromObject{Moon::Get<moon::Object>("config")};
+        REQUIRE(fromObject["height"] == 600);
+    }
+
+    SECTION("invalid views") {
+        auto notTable = Moon::Get<moon::ArrayView<int>>("missing");
+        REQUIRE(logs.ErrorCheck());
+        REQUIRE_FALSE(notTable.IsLoaded());
+        REQUIRE(notTable.GetSize() == 0);
+        REQUIRE(notTable.begin() == notTable.end());
+        moon::TableView<int> empty;
+        REQUIRE(empty.begin() == empty.end());
+        REQUIRE_FALSE(empty.Contains("x"));
+    }
+
+    END_STACK_GUARD
+    INFO(logs.GetError())
+    REQUIRE(logs.NoErrors());
+    Moon::CloseState();
+}
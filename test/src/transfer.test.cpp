@@ -0,0 +1,62 @@
+#include <catch2/catch.hpp>
+
+#include "helpers.h"
+
+TEST_CASE("transfer values between states", "[state][transfer]") {
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    moon::State producer;
+    moon::State consumer;
+    lua_State* source = producer.GetState();
+    lua_State* destination = consumer.GetState();
+
+    SECTION("scalars") {
+        REQUIRE(producer.RunCode("values = {1, 2.5, 'string', true, math.maxinteger}"));
+        lua_getglobal(source, "values");
+        REQUIRE(moon::Transfer(source, -1, destination));
+        lua_setglobal(destination, "values");
+        lua_pop(source, 1);
+        REQUIRE(consumer.RunCode("assert(math.type(values[1]) == 'integer' and math.type(values[2]) == 'float')"));
+        REQUIRE(consumer.RunCode("assert(values[3] == 'string' and values[4] == true and values[5] == math.maxinteger)"));
+    }
+
+    SECTION("shared tables and cycles are copied once") {
+        REQUIRE(producer.RunCode("shared = {x = 1}; data = {a = shared, b = {shared, shared}, nested = {deep = {deeper = 'passed'}}}; "
+                                 "data.self = data; shared.owner = data"));
+        auto data = producer.Get<moon::Object>("data");
+        auto copy = moon::Transfer(data, destination);
+        REQUIRE(copy.IsLoaded());
+        REQUIRE(copy.GetState() == destination);
+        consumer.Set("data", copy);
+        REQUIRE(consumer.RunCode("assert(data.a == data.b[1] and data.b[1] == data.b[2] and data.a.x == 1)"));
+        REQUIRE(consumer.RunCode("assert(data.self == data and data.a.owner == data)"));
+        REQUIRE(consumer.RunCode("assert(data.nested.deep.deeper == 'passed')"));
+        REQUIRE(consumer.RunCode("data.a.x = 2"));
+        REQUIRE(producer.RunCode("assert(shared.x == 1)"));
+    }
+
+    SECTION("values that can not be transferred") {
+        REQUIRE(producer.RunCode("bad = {ok = 1, f = print}"));
+        int top = lua_gettop(destination);
+        lua_getglobal(source, "bad");
+        REQUIRE_FALSE(moon::Transfer(source, -1, destination));
+        lua_pop(source, 1);
+        REQUIRE(lua_gettop(destination) == top);
+        REQUIRE(lua_gettop(source) == 0);
+        REQUIRE_FALSE(logs.NoErrors());
+        logs.Clear();
+    }
+
+    SECTION("threads of the same state share values") {
+        REQUIRE(producer.RunCode("t = {}"));
+        lua_State* thread = lua_newthread(source);
+        lua_getglobal(source, "t");
+        REQUIRE(moon::Transfer(source, -1, thread));
+        REQUIRE(lua_topointer(thread, -1) == lua_topointer(source, -1));
+        lua_settop(thread, 0);
+        lua_settop(source, 0);
+    }
+
+    INFO(logs.GetError())
+    REQUIRE(logs.NoErrors());
+}
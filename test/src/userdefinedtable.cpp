@@ -0,0 +1,9 @@
+#include "userdefinedtype.h"
+
+MOON_DEFINE_BINDING_TABLE(UserDefinedTable,
+                          MOON_TABLE_METHOD(Double),
+                          MOON_TABLE_METHOD(Scale),
+                          MOON_TABLE_PROPERTY(m_prop),
+                          MOON_TABLE_MEMBER(count),
+                          MOON_TABLE_MEMBER(id))
+MOON_LAZY_REGISTRATION;
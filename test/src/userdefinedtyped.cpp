@@ -0,0 +1,12 @@
+#include "userdefinedtype.h"
+
+int UserDefinedTyped::s_instances{0};
+
+MOON_DEFINE_BINDING(UserDefinedTyped)
+MOON_ADD_METHOD(Add)
+MOON_ADD_METHOD(Rename)
+MOON_ADD_METHOD(Describe)
+MOON_ADD_METHOD(Self)
+MOON_ADD_MEMBER(value)
+MOON_ADD_MEMBER(name)
+MOON_ADD_MEMBER(id);
@@ -0,0 +1,9 @@
+#include "userdefinedtype.h"
+
+int UserDefinedValue::s_instances{0};
+
+MOON_DEFINE_BINDING(UserDefinedValue)
+MOON_ADD_PROPERTY(m_x)
+MOON_ADD_PROPERTY(m_y)
+MOON_ADD_METHOD(Self)
+MOON_INLINE_STORAGE;
@@ -22,10 +22,21 @@ TEST_CASE("register user type", "[binding]") {
     }
 
     SECTION("member methods access") {
-        Moon::RunCode("local s = UserDefinedType(20);s.Setter(s.Getter(s.prop));");
+        REQUIRE(Moon::RunCode("local s = UserDefinedType(20);s:Setter(s:Getter(s.prop));"));
         REQUIRE(UserDefinedType::Test() == 40);
     }
 
+    SECTION("member methods are shared closures") {
+        REQUIRE(Moon::RunCode("local s, t = UserDefinedType(1), UserDefinedType(2); assert(s.Getter == t.Getter)"));
+        REQUIRE(Moon::RunCode("local s, t = UserDefinedType(1), UserDefinedType(2); assert(s:Getter(1) == 2 and t:Getter(1) == 3)"));
+        REQUIRE_FALSE(Moon::RunCode("local s = UserDefinedType(1); s.Getter(1)"));
+        REQUIRE_FALSE(Moon::RunCode("local s = UserDefinedType(1); s.Getter = 1"));
+    }
+
+    SECTION("unknown fields") {
+        REQUIRE(Moon::RunCode("local s = UserDefinedType(1); assert(s.unknown == nil); s.unknown = 1; assert(s.unknown == nil)"));
+    }
+
     Moon::CloseState();
 }
 
@@ -95,3 +106,269 @@ TEST_CASE("use user type in functions", "[scripting][functions]") {
 
     Moon::CloseState();
 }
+
+TEST_CASE("user type with inline storage", "[binding]") {
+    Moon::Init();
+    Moon::RegisterClass<UserDefinedValue>();
+    lua_gc(Moon::GetState(), LUA_GCCOLLECT, 0);
+    int instances = UserDefinedValue::Instances();
+
+    SECTION("objects are stored in userdata") {
+        BEGIN_STACK_GUARD
+        REQUIRE(Moon::RunCode("return UserDefinedValue(1.5, 2.5)"));
+        REQUIRE(lua_rawlen(Moon::GetState(), -1) > sizeof(UserDefinedValue*));
+        auto* value = Moon::Get<UserDefinedValue*>(-1);
+        REQUIRE(static_cast<void*>(value) > lua_touserdata(Moon::GetState(), -1));
+        REQUIRE(value->Length() == 4.0);
+        REQUIRE(UserDefinedValue::Instances() == instances + 1);
+        Moon::Pop();
+        END_STACK_GUARD
+    }
+
+    SECTION("properties access") {
+        REQUIRE(Moon::RunCode("local v = UserDefinedValue(1.5, 2.5); v.m_x = 3.5; assert(v.m_x + v.m_y == 6)"));
+    }
+
+    SECTION("objects are destroyed when collected") {
+        REQUIRE(Moon::RunCode("for i = 1, 100 do local v = UserDefinedValue(i + 0.5, i + 0.5) end"));
+        lua_gc(Moon::GetState(), LUA_GCCOLLECT, 0);
+        REQUIRE(UserDefinedValue::Instances() == instances);
+    }
+
+    SECTION("pushed back objects are never given another owner") {
+        std::string info, warning, error;
+        LoggerSetter logs{info, warning, error};
+        BEGIN_STACK_GUARD
+        lua_State* L = Moon::GetState();
+        REQUIRE(Moon::RunCode("v = UserDefinedValue(1.5, 2.5); assert(rawequal(v:Self(), v))"));
+        auto* value = Moon::Get<UserDefinedValue*>("v");
+        Moon::Push(value, moon::Borrow(value), moon::Own(value));
+        lua_getglobal(L, "v");
+        REQUIRE(lua_rawequal(L, -1, -3));
+        REQUIRE(lua_rawequal(L, -1, -4));
+        REQUIRE(lua_isnil(L, -2));
+        REQUIRE(logs.ErrorCheck());
+        Moon::Pop(4);
+        Moon::Push(std::shared_ptr<UserDefinedValue>(value, [](UserDefinedValue*) {}));
+        REQUIRE(lua_isnil(L, -1));
+        REQUIRE(logs.ErrorCheck());
+        Moon::Pop();
+        REQUIRE(Moon::RunCode("v = nil"));
+        lua_gc(L, LUA_GCCOLLECT, 0);
+        REQUIRE(UserDefinedValue::Instances() == instances);
+        END_STACK_GUARD
+    }
+
+    Moon::CloseState();
+    REQUIRE(UserDefinedValue::Instances() == instances);
+}
+
+TEST_CASE("user type with typed methods and members", "[binding]") {
+    Moon::Init();
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    Moon::RegisterClass<UserDefinedTyped>();
+
+    SECTION("typed methods") {
+        BEGIN_STACK_GUARD
+        REQUIRE(Moon::RunCode("local t = UserDefinedTyped(2); assert(t:Add(3) == 5)"));
+        REQUIRE(Moon::RunCode("local t = UserDefinedTyped(2); t:Rename('moon'); assert(t:Describe('name: ') == 'name: moon')"));
+        REQUIRE_FALSE(Moon::RunCode("local t = UserDefinedTyped(2); t.Add(3)"));
+        END_STACK_GUARD
+    }
+
+    SECTION("typed members") {
+        BEGIN_STACK_GUARD
+        REQUIRE(Moon::RunCode("t = UserDefinedTyped(2); t.value = t.value + 1; t.name = 'changed'; assert(t.id == 42)"));
+        auto* typed = Moon::Get<UserDefinedTyped*>("t");
+        REQUIRE(typed->value == 3);
+        REQUIRE(typed->name == "changed");
+        REQUIRE_FALSE(Moon::RunCode("t.id = 1"));
+        REQUIRE(error.find("read only property [id]") != std::string::npos);
+        REQUIRE(typed->id == 42);
+        END_STACK_GUARD
+    }
+
+    SECTION("objects pushed back keep their userdata") {
+        BEGIN_STACK_GUARD
+        lua_gc(Moon::GetState(), LUA_GCCOLLECT, 0);
+        int instances = UserDefinedTyped::Instances();
+        REQUIRE(Moon::RunCode("t = UserDefinedTyped(2); assert(rawequal(t:Self(), t))"));
+        auto* typed = Moon::Get<UserDefinedTyped*>("t");
+        Moon::Push(typed, moon::Own(typed));
+        lua_getglobal(Moon::GetState(), "t");
+        REQUIRE(lua_rawequal(Moon::GetState(), -1, -2));
+        REQUIRE(lua_rawequal(Moon::GetState(), -1, -3));
+        Moon::Pop(3);
+        Moon::Push(std::shared_ptr<UserDefinedTyped>(typed, [](UserDefinedTyped*) {}));
+        REQUIRE(lua_isnil(Moon::GetState(), -1));
+        REQUIRE(logs.ErrorCheck());
+        Moon::Pop();
+        REQUIRE(Moon::RunCode("t = nil"));
+        lua_gc(Moon::GetState(), LUA_GCCOLLECT, 0);
+        REQUIRE(UserDefinedTyped::Instances() == instances);
+        END_STACK_GUARD
+    }
+
+    Moon::CloseState();
+}
+
+TEST_CASE("user type from compile time binding table", "[binding]") {
+    Moon::Init();
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+
+    SECTION("entries are built at compile time") {
+        using LuaTable = moon::LuaClass<UserDefinedTable>;
+        constexpr auto table = moon::MakeBindingTable<UserDefinedTable>(LuaTable::MakeProperty<&UserDefinedTable::count>("count"),
+                                                                        LuaTable::MakeMethod<&UserDefinedTable::Scale>("Scale"));
+        static_assert(table.methods.size() == 1 && table.properties.size() == 1);
+        REQUIRE(std::string{table.methods[0].name} == "Scale");
+        static_assert(!table.indexed && table.functions[1].name == nullptr);
+        REQUIRE(table.functions[0].func == table.methods[0].dispatch);
+        REQUIRE(UserDefinedTable::Binding.GetFunctions() != nullptr);
+        REQUIRE(UserDefinedTable::Binding.GetMethods().size() == 2);
+        REQUIRE(UserDefinedTable::Binding.GetProperties().size() == 3);
+    }
+
+    SECTION("metatable is created on first use") {
+        BEGIN_STACK_GUARD
+        Moon::RegisterClass<UserDefinedTable>();
+        REQUIRE(luaL_getmetatable(Moon::GetState(), "UserDefinedTable") == LUA_TNIL);
+        lua_pop(Moon::GetState(), 1);
+        REQUIRE(Moon::RunCode("t = UserDefinedTable(3); t.count = t.count + 1; assert(t:Double() == 6 and t:Scale(3) == 9)"));
+        REQUIRE(Moon::RunCode("t.m_prop = 5; assert(t.m_prop == 5 and t:Double() == 10 and t.id == 7 and t.count == 1)"));
+        REQUIRE(luaL_getmetatable(Moon::GetState(), "UserDefinedTable") == LUA_TTABLE);
+        lua_pop(Moon::GetState(), 1);
+        REQUIRE_FALSE(Moon::RunCode("t.id = 1"));
+        REQUIRE(error.find("read only property [id]") != std::string::npos);
+        REQUIRE_FALSE(Moon::RunCode("t.Double()"));
+        END_STACK_GUARD
+    }
+
+    SECTION("pushing from C++ creates metatable") {
+        BEGIN_STACK_GUARD
+        lua_State* L = Moon::GetState();
+        lua_pushinteger(L, 4);
+        UserDefinedTable object{L};
+        lua_pop(L, 1);
+        Moon::Push(moon::Borrow(&object));
+        Moon::Pop();
+        REQUIRE(luaL_getmetatable(L, "UserDefinedTable") == LUA_TTABLE);
+        lua_pop(L, 1);
+        Moon::Set("object", moon::Borrow(&object));
+        REQUIRE(Moon::RunCode("assert(object:Scale(2) == 8)"));
+        END_STACK_GUARD
+    }
+
+    Moon::CloseState();
+}
+
+TEST_CASE("user type ownership policies", "[binding]") {
+    Moon::Init();
+    std::string info, warning, error;
+    LoggerSetter logs{info, warning, error};
+    Moon::RegisterClass<UserDefinedValue>();
+    lua_State* L = Moon::GetState();
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    int instances = UserDefinedValue::Instances();
+    lua_pushnumber(L, 1.5);
+    lua_pushnumber(L, 2.5);
+    UserDefinedValue value{L};
+    lua_pop(L, 2);
+
+    SECTION("borrowed objects reuse their userdata") {
+        BEGIN_STACK_GUARD
+        Moon::Push(moon::Borrow(&value), moon::Borrow(&value));
+        REQUIRE(lua_rawequal(L, -1, -2));
+        REQUIRE(Moon::Get<UserDefinedValue*>(-1) == &value);
+        Moon::Pop(2);
+        Moon::Set("borrowed", moon::Borrow(&value));
+        REQUIRE(Moon::RunCode("assert(borrowed.m_x == 1.5); borrowed = nil"));
+        lua_gc(L, LUA_GCCOLLECT, 0);
+        REQUIRE(UserDefinedValue::Instances() == instances + 1);
+        END_STACK_GUARD
+    }
+
+    SECTION("owned objects are deleted when collected") {
+        BEGIN_STACK_GUARD
+        auto* owned = new UserDefinedValue{value};
+        Moon::Push(moon::Own(owned), moon::Borrow(owned));
+        REQUIRE(lua_rawequal(L, -1, -2));
+        Moon::Pop(2);
+        REQUIRE(UserDefinedValue::Instances() == instances + 2);
+        lua_gc(L, LUA_GCCOLLECT, 0);
+        REQUIRE(UserDefinedValue::Instances() == instances + 1);
+        END_STACK_GUARD
+    }
+
+    SECTION("borrowed userdata is taken over by owner") {
+        BEGIN_STACK_GUARD
+        auto* owned = new UserDefinedValue{value};
+        Moon::Push(moon::Borrow(owned), moon::Own(owned));
+        REQUIRE(lua_rawequal(L, -1, -2));
+        Moon::Pop(2);
+        lua_gc(L, LUA_GCCOLLECT, 0);
+        REQUIRE(UserDefinedValue::Instances() == instances + 1);
+        END_STACK_GUARD
+    }
+
+    SECTION("plain pointers follow class GC through cache") {
+        BEGIN_STACK_GUARD
+        auto* owned = new UserDefinedValue{value};
+        Moon::Push(owned, moon::Borrow(owned), owned);
+        REQUIRE(lua_rawequal(L, -1, -2));
+        REQUIRE(lua_rawequal(L, -1, -3));
+        Moon::Pop(3);
+        lua_gc(L, LUA_GCCOLLECT, 0);
+        REQUIRE(UserDefinedValue::Instances() == instances + 1);
+        END_STACK_GUARD
+    }
+
+    SECTION("conflicting owners are refused") {
+        BEGIN_STACK_GUARD
+        auto shared = std::make_shared<UserDefinedValue>(value);
+        Moon::Push(shared, moon::Own(shared.get()));
+        REQUIRE(lua_isnil(L, -1));
+        REQUIRE(logs.ErrorCheck());
+        Moon::Pop(2);
+        auto* owned = new UserDefinedValue{value};
+        Moon::Push(moon::Own(owned), std::shared_ptr<UserDefinedValue>(owned, [](UserDefinedValue*) {}));
+        REQUIRE(lua_isnil(L, -1));
+        REQUIRE(logs.ErrorCheck());
+        Moon::Pop(2);
+        lua_gc(L, LUA_GCCOLLECT, 0);
+        REQUIRE(shared.use_count() == 1);
+        REQUIRE(UserDefinedValue::Instances() == instances + 2);
+        END_STACK_GUARD
+    }
+
+    SECTION("shared objects are released when collected") {
+        BEGIN_STACK_GUARD
+        auto shared = std::make_shared<UserDefinedValue>(value);
+        Moon::Push(shared, shared);
+        REQUIRE(lua_rawequal(L, -1, -2));
+        REQUIRE(shared.use_count() == 2);
+        REQUIRE(Moon::Get<UserDefinedValue*>(-1)->Length() == 4.0);
+        Moon::Pop(2);
+        lua_gc(L, LUA_GCCOLLECT, 0);
+        REQUIRE(shared.use_count() == 1);
+        std::weak_ptr<UserDefinedValue> weak{shared};
+        Moon::Push(std::move(shared));
+        Moon::Pop();
+        lua_gc(L, LUA_GCCOLLECT, 0);
+        REQUIRE(weak.expired());
+        END_STACK_GUARD
+    }
+
+    SECTION("null pointers are pushed as nil") {
+        BEGIN_STACK_GUARD
+        Moon::Push(moon::Borrow<UserDefinedValue>(nullptr));
+        REQUIRE(lua_isnil(L, -1));
+        Moon::Pop();
+        END_STACK_GUARD
+    }
+
+    Moon::CloseState();
+    REQUIRE(UserDefinedValue::Instances() == instances + 1);
+}